@@ -0,0 +1,154 @@
+#ifndef ALOCACAO_H
+#define ALOCACAO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#ifdef HASH_NUMA
+#include <numa.h>
+#endif
+
+/* POLITICAS DE ALOCACAO */
+
+#define PAGINA_GRANDE   (2 * 1024 * 1024)
+
+#define ALOCA_CALLOC    0 // calloc comum (padrao)
+#define ALOCA_PAGINAS_GRANDES 1 // pede paginas de 2 MB, com fallback
+#define ALOCA_HUGETLB   2 // obtida: mmap com MAP_HUGETLB
+#define ALOCA_THP       3 // obtida: mmap alinhado com madvise(MADV_HUGEPAGE)
+#define ALOCA_MMAP      4 // obtida: mmap com paginas comuns
+
+/* ESTRUTURA DA ARENA DE REGISTROS */
+
+typedef struct tbloco {
+     struct tbloco * prox;
+     size_t usado;
+     size_t tamanho;
+     int alocacao; // ALOCA_* obtida para este bloco
+}tbloco;
+
+typedef struct {
+     tbloco * blocos;
+     int politica;
+     int no; // no NUMA dos blocos, -1 = qualquer
+}tarena;
+
+/* FUNCOES DE ALOCACAO */
+
+static inline void * vincula_no(void * p, size_t bytes, int no){
+#ifdef HASH_NUMA
+    if (no >= 0)
+        numa_tonode_memory(p, bytes, no); // Antes do primeiro acesso as paginas
+#else
+    (void)bytes;
+    (void)no;
+#endif
+    return p;
+}
+
+static inline size_t tamanho_mapeado(size_t bytes, int alocacao){
+    size_t pagina = (alocacao == ALOCA_HUGETLB || alocacao == ALOCA_THP) ? PAGINA_GRANDE : 4096;
+    return (bytes + pagina - 1) & ~(pagina - 1);
+}
+
+static inline void * aloca_paginas(size_t bytes, int politica, int no, int * alocacao){ // Devolve memoria zerada
+    if (politica == ALOCA_CALLOC && no < 0){
+        *alocacao = ALOCA_CALLOC;
+        return calloc(1, bytes);
+    }
+    void * p;
+    if (politica == ALOCA_PAGINAS_GRANDES && bytes >= PAGINA_GRANDE / 2){ // Abaixo disso a pagina grande desperdica memoria
+        size_t tam = tamanho_mapeado(bytes, ALOCA_HUGETLB);
+#ifdef MAP_HUGETLB
+        p = mmap(NULL, tam, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED){
+            *alocacao = ALOCA_HUGETLB;
+            return vincula_no(p, tam, no);
+        }
+#endif
+        // Sem paginas reservadas: regiao alinhada a 2 MB para o THP
+        p = mmap(NULL, tam + PAGINA_GRANDE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p != MAP_FAILED){
+            uintptr_t ini = ((uintptr_t)p + PAGINA_GRANDE - 1) & ~(uintptr_t)(PAGINA_GRANDE - 1);
+            uintptr_t fim = (uintptr_t)p + tam + PAGINA_GRANDE;
+            if (ini > (uintptr_t)p)
+                munmap(p, ini - (uintptr_t)p);
+            if (fim > ini + tam)
+                munmap((void *)(ini + tam), fim - (ini + tam));
+#ifdef MADV_HUGEPAGE
+            madvise((void *)ini, tam, MADV_HUGEPAGE);
+#endif
+            *alocacao = ALOCA_THP;
+            return vincula_no((void *)ini, tam, no);
+        }
+    }
+    size_t tam = tamanho_mapeado(bytes, ALOCA_MMAP);
+    p = mmap(NULL, tam, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p != MAP_FAILED){
+        *alocacao = ALOCA_MMAP;
+        return vincula_no(p, tam, no);
+    }
+    *alocacao = ALOCA_CALLOC;
+    return calloc(1, bytes);
+}
+
+static inline void libera_paginas(void * p, size_t bytes, int alocacao){
+    if (p == NULL)
+        return;
+    if (alocacao == ALOCA_CALLOC)
+        free(p);
+    else
+        munmap(p, tamanho_mapeado(bytes, alocacao));
+}
+
+static inline const char * nome_alocacao(int alocacao){
+    switch (alocacao){
+        case ALOCA_HUGETLB: return "hugetlb";
+        case ALOCA_THP: return "thp";
+        case ALOCA_MMAP: return "mmap 4k";
+        default: return "calloc";
+    }
+}
+
+static inline tarena * arena_cria(int politica, int no){
+    tarena * a = (tarena *)malloc(sizeof(tarena));
+    if (a == NULL)
+        return NULL;
+    a->blocos = NULL;
+    a->politica = politica;
+    a->no = no;
+    return a;
+}
+
+static inline void * arena_aloca(tarena * a, size_t bytes){ // Alocacao sequencial, liberada toda de uma vez em arena_apaga
+    bytes = (bytes + 7) & ~(size_t)7;
+    if (bytes > PAGINA_GRANDE - sizeof(tbloco)) // Nao cabe nem num bloco vazio
+        return NULL;
+    tbloco * b = a->blocos;
+    if (b == NULL || b->usado + bytes > b->tamanho){
+        int alocacao;
+        b = (tbloco *)aloca_paginas(PAGINA_GRANDE, a->politica, a->no, &alocacao);
+        if (b == NULL)
+            return NULL;
+        b->prox = a->blocos;
+        b->usado = sizeof(tbloco);
+        b->tamanho = PAGINA_GRANDE;
+        b->alocacao = alocacao;
+        a->blocos = b;
+    }
+    void * p = (char *)b + b->usado;
+    b->usado += bytes;
+    return p;
+}
+
+static inline void arena_apaga(tarena * a){
+    tbloco * b = a->blocos;
+    while (b != NULL){
+        tbloco * prox = b->prox;
+        libera_paginas(b, b->tamanho, b->alocacao);
+        b = prox;
+    }
+    free(a);
+}
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef CEP_DIGITOS
+#define CEP_DIGITOS 8 // Chaves de 8 digitos para o arquivo sintetico nao repetir CEP
+#endif
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "cep.h"
+
+/* Compara a carga serial (fgets + parse + insere na mesma thread) com a
+   carga em pipeline de carga.h num arquivo CSV sintetico grande, com o
+   arquivo fora e dentro do cache de paginas.
+   Uso: bench_carga [MB] [arquivo] */
+
+#define HT_CHAVE(h, reg)    (((tcep *)(reg))->cep_ini)
+#include "hash_tabela.h"
+#include "dataset.h"
+#include "carga.h"
+
+/* FUNCOES AUXILIARES */
+
+static int gera_sintetico(const char * caminho, long megabytes){
+    /* Repete as linhas do ceps.csv com cep_ini de 8 digitos distintos.
+       i * 7919 mod 10^8 e uma permutacao, entao nenhuma chave repete */
+    FILE * entrada = fopen("ceps.csv", "r");
+    FILE * saida = fopen(caminho, "w");
+    if (entrada == NULL || saida == NULL){
+        fprintf(stderr, "Erro ao gerar o arquivo %s\n", caminho);
+        return EXIT_FAILURE;
+    }
+    char line[256];
+    tcep * base = NULL;
+    int nbase = 0, capbase = 0;
+    fgets(line, sizeof(line), entrada);
+    fputs(line, saida);
+    while (fgets(line, sizeof(line), entrada)){
+        tcep cep;
+        if (le_linha_cep(line, &cep) == EXIT_FAILURE)
+            continue;
+        if (nbase == capbase){
+            capbase = capbase ? 2 * capbase : 1024;
+            base = realloc(base, sizeof(*base) * capbase);
+        }
+        base[nbase++] = cep;
+    }
+    fclose(entrada);
+
+    long limite = megabytes * 1024 * 1024;
+    for (long i = 0; ftell(saida) < limite; i++){
+        tcep * cep = &base[i % nbase];
+        long ini = (i * 7919) % 100000000L;
+        long fim = ini + 999 < 100000000L ? ini + 999 : 99999999L;
+        fprintf(saida, "%s,%s,%05ld-%03ld a %05ld-%03ld,%08ld,%08ld,Sintetico,Total do municipio\n",
+                cep->estado, cep->cidade, ini / 1000, ini % 1000, fim / 1000, fim % 1000, ini, fim);
+    }
+    free(base);
+    fclose(saida);
+    return EXIT_SUCCESS;
+}
+
+static void descarta_cache(const char * caminho){ // Tira o arquivo do cache de paginas (paginas limpas)
+    int fd = open(caminho, O_RDONLY);
+    if (fd < 0)
+        return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+static double agora_s(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static int carga_serial(thash * h, const char * caminho){
+    FILE * file = fopen(caminho, "r");
+    if (!file)
+        return EXIT_FAILURE;
+    int resultado = ler_CSV(file, h);
+    fclose(file);
+    return resultado;
+}
+
+static void mede(const char * rotulo, int (*carga)(thash *, const char *), const char * caminho, int frio,
+                 long bytes, int * registros){
+    thash h;
+    assert(hash_constroi(&h, 6100, get_key, 0.7) == EXIT_SUCCESS);
+    if (frio)
+        descarta_cache(caminho);
+    double ini = agora_s();
+    assert(carga(&h, caminho) == EXIT_SUCCESS);
+    double t = agora_s() - ini;
+    printf("%-8s %-6s: %7.3f s, %6.1f MB/s, %8d registros\n", rotulo, frio ? "frio" : "quente", t,
+           bytes / t / (1024 * 1024), h.size);
+    if (*registros < 0)
+        *registros = h.size;
+    assert(*registros == h.size); // As duas cargas devem montar a mesma tabela
+    hash_apaga(&h);
+}
+
+int main(int argc, char * argv[]){
+    long megabytes = argc > 1 ? atol(argv[1]) : 300;
+    const char * caminho = argc > 2 ? argv[2] : "/tmp/ceps_sintetico.csv";
+
+    thash h; // Erro de leitura (read num diretorio da EISDIR) falha a carga em vez de truncar
+    assert(hash_constroi(&h, 6100, get_key, 0.7) == EXIT_SUCCESS);
+    assert(carga_pipeline(&h, ".") == EXIT_FAILURE);
+    hash_apaga(&h);
+
+    FILE * f = fopen(caminho, "r");
+    if (f != NULL){
+        fseek(f, 0, SEEK_END);
+        if (ftell(f) < megabytes * 1024 * 1024){
+            fclose(f);
+            f = NULL;
+        }
+    }
+    if (f == NULL){
+        printf("Gerando %s com %ld MB...\n", caminho, megabytes);
+        if (gera_sintetico(caminho, megabytes) == EXIT_FAILURE)
+            return EXIT_FAILURE;
+        f = fopen(caminho, "r");
+        fseek(f, 0, SEEK_END);
+    }
+    long bytes = ftell(f);
+    fclose(f);
+
+    int registros = -1;
+    for (int frio = 1; frio >= 0; frio--){
+        mede("serial", carga_serial, caminho, frio, bytes, &registros);
+        mede("pipeline", carga_pipeline, caminho, frio, bytes, &registros);
+    }
+    return EXIT_SUCCESS;
+}
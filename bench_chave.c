@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include "cep.h"
+
+/* Mede o ganho de tirar a chamada indireta a get_key do caminho quente:
+   as mesmas sondagens instanciadas com a chave direta (HT_CHAVE) e com
+   o ponteiro de funcao, como nas versoes antigas de hash_sl.c e hash_hd.c */
+
+/* TABELA PADRAO, USADA SO PARA CARREGAR O DATASET */
+
+#define HT_CHAVE(h, reg)    (((tcep *)(reg))->cep_ini)
+#include "hash_tabela.h"
+#include "dataset.h"
+
+/* INSTANCIAS COMPARADAS (os registros pertencem a tabela padrao) */
+
+#define HT_PREFIXO          lin_direta
+#define HT_TIPO             tlin_direta
+#define HT_SONDAGEM         HT_LINEAR
+#define HT_CHAVE(h, reg)    (((tcep *)(reg))->cep_ini)
+#define HT_LIBERA(reg)      (void)(reg)
+#include "hash_tabela.h"
+
+#define HT_PREFIXO          lin_indireta
+#define HT_TIPO             tlin_indireta
+#define HT_SONDAGEM         HT_LINEAR
+#define HT_LIBERA(reg)      (void)(reg)
+#include "hash_tabela.h"
+
+#define HT_PREFIXO          dup_direta
+#define HT_TIPO             tdup_direta
+#define HT_SONDAGEM         HT_DUPLA
+#define HT_CHAVE(h, reg)    (((tcep *)(reg))->cep_ini)
+#define HT_LIBERA(reg)      (void)(reg)
+#include "hash_tabela.h"
+
+#define HT_PREFIXO          dup_indireta
+#define HT_TIPO             tdup_indireta
+#define HT_SONDAGEM         HT_DUPLA
+#define HT_LIBERA(reg)      (void)(reg)
+#include "hash_tabela.h"
+
+#define HT_PREFIXO          quad_direta
+#define HT_TIPO             tquad_direta
+#define HT_SONDAGEM         HT_QUADRATICA
+#define HT_CHAVE(h, reg)    (((tcep *)(reg))->cep_ini)
+#define HT_LIBERA(reg)      (void)(reg)
+#include "hash_tabela.h"
+
+#define NREPETICOES 200
+
+// volatile impede o compilador de trocar a chamada indireta pela direta
+char * (* volatile chave_indireta)(void *) = get_key;
+
+double segundos(clock_t start, clock_t end){
+    return ((double) (end - start)) / CLOCKS_PER_SEC;
+}
+
+/* Gera o comparativo de uma instancia: insere todos os registros e busca todas as chaves */
+#define MEDE(prefixo, tipo, rotulo) do {                                                \
+    double t_insere = 0, t_busca = 0;                                                   \
+    long encontrados = 0;                                                               \
+    for (int r = 0; r < NREPETICOES; r++){                                              \
+        tipo t;                                                                         \
+        assert(prefixo##_constroi(&t, nregs, chave_indireta, 0.7) == EXIT_SUCCESS);     \
+        clock_t start = clock();                                                        \
+        for (int i = 0; i < nregs; i++)                                                 \
+            prefixo##_insere(&t, regs[i]);                                              \
+        clock_t meio = clock();                                                         \
+        for (int i = 0; i < nregs; i++)                                                 \
+            encontrados += prefixo##_busca(t, ((tcep *)regs[i])->cep_ini) != NULL;      \
+        clock_t end = clock();                                                          \
+        t_insere += segundos(start, meio);                                              \
+        t_busca += segundos(meio, end);                                                 \
+        prefixo##_apaga(&t);                                                            \
+    }                                                                                   \
+    assert(encontrados == (long)nregs * NREPETICOES);                                   \
+    printf("%-18s: insercao %6.2f ns/op, busca %6.2f ns/op\n", rotulo,                  \
+           t_insere * 1e9 / ((double)nregs * NREPETICOES),                              \
+           t_busca * 1e9 / ((double)nregs * NREPETICOES));                              \
+} while (0)
+
+/* MAIN */
+
+int main(int argc, char* argv[]){
+    thash h;
+    assert(constroi_dataset(&h, 6100, get_key, 0.7) == EXIT_SUCCESS);
+    void ** regs = malloc(sizeof(void *) * h.size);
+    int nregs = 0;
+    for (int i = 0; i < h.max; i++){
+        if (hash_registro(h, i) != NULL)
+            regs[nregs++] = hash_registro(h, i);
+    }
+
+    printf("Chave direta x get_key indireto (%d registros, %d repeticoes)...\n", nregs, NREPETICOES);
+    MEDE(lin_direta, tlin_direta, "linear direta");
+    MEDE(lin_indireta, tlin_indireta, "linear indireta");
+    MEDE(dup_direta, tdup_direta, "dupla direta");
+    MEDE(dup_indireta, tdup_indireta, "dupla indireta");
+    MEDE(quad_direta, tquad_direta, "quadratica direta");
+
+    free(regs);
+    hash_apaga(&h);
+    return 0;
+}
@@ -0,0 +1,235 @@
+#ifndef CEP_DIGITOS
+#define CEP_DIGITOS 8 // Chaves completas do gerador
+#endif
+#ifndef VARIANTE
+#define VARIANTE 1 // 1 linear, 2 dupla, 3 quadratica, 4 cuckoo
+#endif
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include "cep.h"
+#include "cep_indice.h"
+#include "contadores.h"
+
+/* Comparativo em escala: insercao, busca com acerto, busca com falha,
+   consulta por faixa e remocao, para um dataset do gerador e varias taxas
+   de ocupacao. Uma variante por binario (-DVARIANTE=n); a saida e CSV
+   (variante,linhas,taxa,operacao,ns_op,ocupacao e os contadores de
+   contadores.h por operacao, vazios quando indisponiveis) para o plota_escala.py.
+   A ocupacao medida tem de ficar a TOLERANCIA da taxa pedida, senao o
+   binario falha; a quadratica pode carregar so parte das linhas para isso.
+   Uso: bench_escala <dataset.csv> [taxa...] */
+
+#define HT_CHAVE(h, reg)      (((tcep *)(reg))->cep_ini)
+#define HT_LIBERA(reg)        (void)(reg) // Os registros pertencem ao vetor do benchmark
+#define HT_AO_INSERIR(h, reg) indice_insere((tindice *)(h)->indice, (tcep *)(reg))
+#define HT_AO_REMOVER(h, reg) indice_remove((tindice *)(h)->indice, (tcep *)(reg))
+#define HT_AO_APAGAR(h)       indice_apaga((tindice *)(h)->indice)
+#if VARIANTE == 4
+#define NOME_VARIANTE "cuckoo"
+#include "hash_cuckoo.h"
+#else
+#define NOME_VARIANTE (VARIANTE == 1 ? "linear" : VARIANTE == 2 ? "dupla" : "quadratica")
+#define HT_SONDAGEM VARIANTE
+#include "hash_tabela.h"
+#endif
+#include "dataset.h"
+
+#define MAX_CONSULTAS 1000000 // consultas por operacao de busca
+#define NFAIXAS       10000   // consultas por faixa
+#define TOLERANCIA    0.02    // distancia maxima entre a ocupacao medida e a taxa pedida
+
+/* FUNCOES AUXILIARES */
+
+static double agora_ns(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static tcep * le_registros(const char * caminho, int * n){ // Todo o dataset num vetor, fora da medicao
+    FILE * file = fopen(caminho, "r");
+    if (!file){
+        fprintf(stderr, "Erro ao abrir o arquivo %s\n", caminho);
+        return NULL;
+    }
+    char line[256];
+    int cap = 1 << 16;
+    tcep * regs = malloc(sizeof(tcep) * cap);
+    *n = 0;
+    fgets(line, sizeof(line), file);
+    while (fgets(line, sizeof(line), file)){
+        if (*n == cap){
+            cap *= 2;
+            regs = realloc(regs, sizeof(tcep) * cap);
+        }
+        if (le_linha_cep(line, &regs[*n]) == EXIT_SUCCESS)
+            (*n)++;
+    }
+    fclose(file);
+    return regs;
+}
+
+static void embaralha(int * v, int n){
+    for (int i = n - 1; i > 0; i--){
+        int j = (int)(((uint64_t)rand() << 31 | rand()) % (i + 1));
+        int tmp = v[i];
+        v[i] = v[j];
+        v[j] = tmp;
+    }
+}
+
+static void gera_chave(char * chave){ // CEP aleatorio com CEP_DIGITOS digitos
+    for (int i = 0; i < CEP_DIGITOS; i++)
+        chave[i] = '0' + rand() % 10;
+    chave[CEP_DIGITOS] = '\0';
+}
+
+static tcontadores contadores;
+static double inicio_fase;
+
+static void inicia(const char * operacao){
+    contadores_inicia(&contadores, operacao);
+    inicio_fase = agora_ns();
+}
+
+static void imprime(int n, float taxa, const char * operacao, int nops, double ocupacao){ // Fecha a fase e grava a linha
+    double ns = agora_ns() - inicio_fase;
+    contadores_para(&contadores, operacao);
+    printf("%s,%d,%.2f,%s,%.1f,%.3f", NOME_VARIANTE, n, taxa, operacao, ns / nops, ocupacao);
+    contadores_csv(&contadores, stdout, nops);
+    printf("\n");
+}
+
+/* MEDICOES */
+
+static int mede_taxa(tcep * regs, int n, float taxa, char (*ausentes)[CEP_DIGITOS + 1], int nausentes){
+    // Tabela dimensionada para terminar na taxa pedida. Quando o tamanho e
+    // arredondado para cima (potencia de 2 na quadratica), usa a potencia de
+    // baixo e carrega so os primeiros registros que cabem abaixo da taxa
+    thash h;
+    int m = n; // registros carregados
+    assert(hash_constroi(&h, (int)(n / taxa) + 2, get_key, taxa) == EXIT_SUCCESS);
+    if ((double)n / h.max < taxa - TOLERANCIA){
+        int max = h.max / 2;
+        hash_apaga(&h);
+        assert(hash_constroi(&h, max - 1, get_key, taxa) == EXIT_SUCCESS && h.max == max);
+        for (m = (int)(taxa * max); (float)m / max >= taxa; m--) // A insercao de mais um duplicaria
+            ;
+        m = m < n ? m : n;
+    }
+
+    int nconsultas = m < MAX_CONSULTAS ? m : MAX_CONSULTAS;
+    int * ordem = malloc(sizeof(int) * m);
+    for (int i = 0; i < m; i++)
+        ordem[i] = i;
+    embaralha(ordem, m);
+    volatile uintptr_t descarte = 0; // Impede que o compilador elimine as buscas
+
+    inicia("insercao");
+    for (int i = 0; i < m; i++)
+        hash_insere(&h, &regs[i]);
+    double ocupacao = (double)h.size / h.max; // Ocupacao apos a carga, vale para todas as linhas
+    if (ocupacao < taxa - TOLERANCIA || ocupacao > taxa + TOLERANCIA){ // O plota_escala.py agrupa pela taxa
+        contadores_para(&contadores, "insercao");
+        fprintf(stderr, "%s: ocupacao %.3f longe da taxa %.2f pedida\n", NOME_VARIANTE, ocupacao, taxa);
+        hash_apaga(&h);
+        free(ordem);
+        return EXIT_FAILURE;
+    }
+    imprime(n, taxa, "insercao", m, ocupacao);
+
+    inicia("acerto");
+    for (int i = 0; i < nconsultas; i++)
+        descarte += (uintptr_t)hash_busca(h, regs[ordem[i]].cep_ini);
+    imprime(n, taxa, "acerto", nconsultas, ocupacao);
+
+    inicia("falha");
+    for (int i = 0; i < nausentes; i++)
+        descarte += (uintptr_t)hash_busca(h, ausentes[i]);
+    imprime(n, taxa, "falha", nausentes, ocupacao);
+
+    // Faixas de largura 10^(digitos-5), como um CEP de 5 digitos; indice montado fora da medicao
+    tindice * ind = indice_cria();
+    for (int i = 0; i < h.max; i++){
+        if (hash_registro(h, i) != NULL)
+            indice_insere(ind, (tcep *)hash_registro(h, i));
+    }
+    long largura = 1;
+    for (int i = 5; i < CEP_DIGITOS; i++)
+        largura *= 10;
+    char a[CEP_DIGITOS + 1], b[24];
+    inicia("faixa");
+    for (int i = 0; i < NFAIXAS; i++){
+        tcep * r = &regs[ordem[i % m]];
+        long fim = atol(r->cep_ini) + largura - 1;
+        snprintf(a, sizeof(a), "%s", r->cep_ini);
+        snprintf(b, sizeof(b), "%0*ld", CEP_DIGITOS, fim);
+        descarte += indice_intervalo(ind, a, b, NULL, NULL);
+    }
+    imprime(n, taxa, "faixa", NFAIXAS, ocupacao);
+
+    inicia("remocao");
+    for (int i = 0; i < m; i++)
+        hash_remove(&h, regs[ordem[i]].cep_ini);
+    imprime(n, taxa, "remocao", m, ocupacao);
+
+    // Liberacao de uma tabela cheia, por registro
+    for (int i = 0; i < m; i++)
+        hash_insere(&h, &regs[i]);
+    inicia("liberacao");
+    hash_apaga(&h);
+    imprime(n, taxa, "liberacao", m, ocupacao);
+    // So agora: os nos do indice liberados antes ficariam para o free da tabela consolidar
+    indice_apaga(ind);
+    (void)descarte;
+    free(ordem);
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char * argv[]){
+    if (argc < 2){
+        fprintf(stderr, "Uso: %s <dataset.csv> [taxa...]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    int n;
+    tcep * regs = le_registros(argv[1], &n);
+    if (regs == NULL || n == 0)
+        return EXIT_FAILURE;
+
+    // Chaves ausentes, conferidas numa tabela com todo o dataset
+    srand(SEED);
+    int nausentes = n < MAX_CONSULTAS ? n : MAX_CONSULTAS;
+    char (*ausentes)[CEP_DIGITOS + 1] = malloc(sizeof(*ausentes) * nausentes);
+    thash h;
+    assert(hash_constroi(&h, 2 * n, get_key, 0.7) == EXIT_SUCCESS);
+    for (int i = 0; i < n; i++)
+        hash_insere(&h, &regs[i]);
+    for (int i = 0; i < nausentes; ){
+        gera_chave(ausentes[i]);
+        if (hash_busca(h, ausentes[i]) == NULL)
+            i++;
+    }
+    hash_apaga(&h);
+
+    contadores_abre(&contadores);
+    printf("variante,linhas,taxa,operacao,ns_op,ocupacao");
+    contadores_csv_cabecalho(stdout);
+    printf("\n");
+    int resultado = EXIT_SUCCESS;
+    if (argc == 2){
+        float taxas[] = {0.5, 0.7, 0.9};
+        for (int t = 0; t < 3 && resultado == EXIT_SUCCESS; t++)
+            resultado = mede_taxa(regs, n, taxas[t], ausentes, nausentes);
+    }
+    for (int t = 2; t < argc && resultado == EXIT_SUCCESS; t++)
+        resultado = mede_taxa(regs, n, atof(argv[t]), ausentes, nausentes);
+
+    contadores_fecha(&contadores);
+    free(ausentes);
+    free(regs);
+    return resultado;
+}
@@ -0,0 +1,34 @@
+#!/bin/sh
+# Gera os datasets sinteticos, compila uma variante por binario e grava
+# todas as medicoes em um CSV para o plota_escala.py.
+# Variaveis: TAMANHOS, TAXAS, DIGITOS, DIR (datasets e binarios), SAIDA.
+# 10^8 linhas pede DIGITOS=9 e perto de 16 GB de memoria.
+set -e
+
+TAMANHOS=${TAMANHOS:-"10000 100000 1000000 10000000"}
+TAXAS=${TAXAS:-"0.5 0.7 0.9"}
+DIGITOS=${DIGITOS:-8}
+DIR=${DIR:-/tmp/hash_escala}
+SAIDA=${SAIDA:-resultados_escala.csv}
+
+mkdir -p "$DIR"
+gcc -O2 -o "$DIR/gerador" gerador.c
+for v in 1 2 3 4; do
+    gcc -O2 -DCEP_DIGITOS="$DIGITOS" -DVARIANTE=$v -o "$DIR/bench_escala_$v" bench_escala.c
+done
+
+: > "$SAIDA"
+for n in $TAMANHOS; do
+    dataset="$DIR/ceps_${n}_${DIGITOS}.csv"
+    [ -f "$dataset" ] || "$DIR/gerador" "$n" "$dataset" "$DIGITOS"
+    for v in 1 2 3 4; do
+        echo "linhas $n, variante $v" >&2
+        # O cabecalho (com as colunas dos contadores) vem da primeira execucao
+        if [ -s "$SAIDA" ]; then
+            "$DIR/bench_escala_$v" "$dataset" $TAXAS | tail -n +2 >> "$SAIDA"
+        else
+            "$DIR/bench_escala_$v" "$dataset" $TAXAS >> "$SAIDA"
+        fi
+    done
+done
+echo "Resultados em $SAIDA" >&2
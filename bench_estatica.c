@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "cep.h"
+
+/* Compara a tabela estatica embutida no executavel (ceps_tabela.h, gerado
+   pelo gera_tabela.c) com a carga do ceps.csv e com a tabela montada em
+   tempo de execucao a partir de registros ja em memoria.
+   A partida da estatica e a primeira busca do processo, com as faltas de
+   pagina do .rodata; as outras sao a media de NREPETICOES montagens.
+   Gere o header antes: ./gera_tabela && gcc -O2 -o bench_estatica bench_estatica.c */
+
+#define HT_CHAVE(h, reg)    (((tcep *)(reg))->cep_ini)
+#include "hash_tabela.h"
+#include "dataset.h"
+
+#define HT_PREFIXO          montada
+#define HT_TIPO             tmontada
+#define HT_CHAVE(h, reg)    (((tcep *)(reg))->cep_ini)
+#define HT_LIBERA(reg)      (void)(reg) // Registros da tabela estatica
+#include "hash_tabela.h"
+
+#if defined(__has_include)
+#if !__has_include("ceps_tabela.h")
+#error "ceps_tabela.h nao existe: gere antes com gcc -O2 -o gera_tabela gera_tabela.c && ./gera_tabela"
+#endif
+#endif
+#include "ceps_tabela.h"
+
+#define NREPETICOES 100
+
+static double agora_ns(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static long faltas_pagina(){
+    struct rusage uso;
+    getrusage(RUSAGE_SELF, &uso);
+    return uso.ru_minflt + uso.ru_majflt;
+}
+
+int main(){
+    // Partida da estatica: nada a montar, so a primeira busca, antes de qualquer acesso a tabela
+    long faltas = faltas_pagina();
+    double ini = agora_ns();
+    testatica e = ceps_estatica;
+    void * primeiro = estatica_busca(e, "69945");
+    double partida_estatica = agora_ns() - ini;
+    faltas = faltas_pagina() - faltas;
+    assert(primeiro != NULL);
+    printf("Tabela estatica: %d registros, %d slots, %zu bytes em .rodata\n", e.size, e.max,
+           sizeof(ceps_registros) + sizeof(ceps_slots));
+
+    // Partida: carga do CSV x tabela montada de registros em memoria x estatica
+    ini = agora_ns();
+    for (int r = 0; r < NREPETICOES; r++){
+        thash h;
+        assert(constroi_dataset(&h, 6100, get_key, 0.7) == EXIT_SUCCESS);
+        hash_apaga(&h);
+    }
+    printf("Partida com carga do CSV : %9.1f us\n", (agora_ns() - ini) / NREPETICOES / 1e3);
+
+    ini = agora_ns();
+    for (int r = 0; r < NREPETICOES; r++){
+        tmontada m;
+        assert(montada_constroi(&m, 6100, get_key, 0.7) == EXIT_SUCCESS);
+        for (int i = 0; i < e.size; i++)
+            montada_insere(&m, (void *)&ceps_registros[i]);
+        montada_apaga(&m);
+    }
+    printf("Partida com tabela montada: %9.1f us\n", (agora_ns() - ini) / NREPETICOES / 1e3);
+    printf("Partida com tabela estatica: %8.1f us (primeira busca, %ld faltas de pagina)\n", partida_estatica / 1e3, faltas);
+
+    // Busca: mesmas chaves, embaralhadas, nas duas tabelas
+    thash h;
+    assert(constroi_dataset(&h, 6100, get_key, 0.7) == EXIT_SUCCESS);
+    const char ** chaves = malloc(sizeof(char *) * e.size);
+    for (int i = 0; i < e.size; i++)
+        chaves[i] = ceps_registros[i].cep_ini;
+    srand(SEED);
+    for (int i = e.size - 1; i > 0; i--){
+        int j = rand() % (i + 1);
+        const char * tmp = chaves[i];
+        chaves[i] = chaves[j];
+        chaves[j] = tmp;
+    }
+    for (int i = 0; i < e.size; i++){ // As duas tabelas devolvem o mesmo registro
+        tcep * a = (tcep *)hash_busca(h, chaves[i]);
+        tcep * b = (tcep *)estatica_busca(e, chaves[i]);
+        assert(a != NULL && b != NULL && memcmp(a, b, sizeof(tcep)) == 0);
+    }
+    for (int i = 0; i < 100000; i++){ // E concordam nas chaves ausentes
+        char chave[6];
+        snprintf(chave, sizeof(chave), "%05d", i);
+        assert((hash_busca(h, chave) == NULL) == (estatica_busca(e, chave) == NULL));
+    }
+
+    volatile uintptr_t descarte = 0;
+    ini = agora_ns();
+    for (int r = 0; r < NREPETICOES; r++)
+        for (int i = 0; i < e.size; i++)
+            descarte += (uintptr_t)hash_busca(h, chaves[i]);
+    printf("Busca na tabela montada   : %6.1f ns/op\n", (agora_ns() - ini) / NREPETICOES / e.size);
+    ini = agora_ns();
+    for (int r = 0; r < NREPETICOES; r++)
+        for (int i = 0; i < e.size; i++)
+            descarte += (uintptr_t)estatica_busca(e, chaves[i]);
+    printf("Busca na tabela estatica  : %6.1f ns/op\n", (agora_ns() - ini) / NREPETICOES / e.size);
+    (void)descarte;
+
+    free(chaves);
+    hash_apaga(&h);
+    return 0;
+}
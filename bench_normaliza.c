@@ -0,0 +1,232 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include "cep.h"
+#include "normaliza.h"
+
+/* Consultas em texto (uma por linha) ate o registro: caminho escalar, que
+   normaliza e busca uma chave por vez, contra o lote, que normaliza com
+   SSE2 + SWAR e passa CEPs e bitmap de malformadas ao busca_lote.
+   O lote busca na tabela de chave texto (cada CEP volta a ser texto com
+   cep_chave) e na de chave uint32_t, que recebe os CEPs como sairam.
+   Mede GB/s de texto bruto, so a normalizacao e normalizacao + busca.
+   Uso: bench_normaliza [consultas] */
+
+#define HT_CHAVE(h, reg)    (((tcep *)(reg))->cep_ini)
+#include "hash_tabela.h"
+#include "dataset.h"
+
+#define HT_PREFIXO          num
+#define HT_TIPO             tnum
+#define HT_TIPO_CHAVE       uint32_t
+#define HT_CHAVE(h, reg)    cep_numero(((tcep *)(reg))->cep_ini)
+#define HT_HASH(key)        hash_cep(key)
+#define HT_HASH2(key)       hash2_cep(key)
+#define HT_IGUAL(a, b)      CEP_IGUAL(a, b)
+#define HT_CHAVE_CACHE(key) ((int)((key) / divisor_cep()))
+#define HT_LIBERA(reg)      (void)(reg) // Os registros sao da tabela de chave texto
+#include "hash_tabela.h"
+
+#define TAM_LOTE    1024 // consultas por chamada ao normaliza_lote
+#define NREPETICOES 5
+
+static double agora_ns(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/* TESTES */
+
+static void teste_normaliza(){
+    const char * texto = "69945-000\n69945000\n  01000-123 \t\r\n\n6994-5000\n69945-00a\n699450000\n"
+                         "69945 000\n                 69945000\n69945--00\n-69945000\n00000-000\n99999999";
+    uint32_t esperado[] = {69945000, 69945000, 1000123, 0, 0, 0, 0, 0, 69945000, 0, 0, 0, 99999999};
+    int invalido[] = {0, 0, 0, 1, 1, 1, 1, 1, 0, 1, 1, 0, 0};
+    int nesperado = sizeof(esperado) / sizeof(esperado[0]);
+
+    uint32_t ceps[64];
+    uint64_t malformados[1];
+    int n;
+    size_t consumido = normaliza_lote(texto, strlen(texto), ceps, malformados, 64, &n);
+    assert(n == nesperado && consumido == strlen(texto));
+    for (int i = 0; i < n; i++){
+        assert(ceps[i] == esperado[i]);
+        assert((int)(malformados[0] >> i & 1) == invalido[i]);
+    }
+
+    // Lote menor que o texto: para na linha max e continua dali
+    consumido = normaliza_lote(texto, strlen(texto), ceps, malformados, 2, &n);
+    assert(n == 2 && consumido == 19);
+
+    char chave[CEP_DIGITOS + 1];
+    cep_chave(1000123, chave);
+    assert(strncmp(chave, "01000123", CEP_DIGITOS) == 0 && chave[CEP_DIGITOS] == '\0');
+    printf("Teste de normalizacao concluido\n");
+}
+
+/* GERACAO DAS CONSULTAS */
+
+static char * gera_consultas(thash h, int n, size_t * tamanho){
+    // CEPs de faixas do dataset, em varios formatos; ~3% ausentes e ~6% malformados
+    char * texto = malloc((size_t)n * 24);
+    size_t t = 0;
+    for (int i = 0; i < n; i++){
+        tcep * r;
+        do
+            r = (tcep *)hash_registro(h, rand() % h.max);
+        while (r == NULL);
+        long cep = atol(r->cep_ini) * 1000 + rand() % 1000;
+        int sorteio = rand() % 100;
+        if (sorteio < 3)
+            cep = rand() % 100000000; // Quase sempre ausente
+        if (sorteio < 40)
+            t += sprintf(texto + t, "%05ld-%03ld\n", cep / 1000, cep % 1000);
+        else if (sorteio < 80)
+            t += sprintf(texto + t, "%08ld\n", cep);
+        else if (sorteio < 94)
+            t += sprintf(texto + t, " \t%05ld-%03ld  \r\n", cep / 1000, cep % 1000);
+        else if (sorteio < 97)
+            t += sprintf(texto + t, "%04ld-%04ld\n", cep / 10000, cep % 10000);
+        else
+            t += sprintf(texto + t, "%05ldx%03ld\n", cep / 1000, cep % 1000);
+    }
+    *tamanho = t;
+    return texto;
+}
+
+/* CAMINHOS MEDIDOS */
+
+static tnum numerica; // Mesmos registros, chave uint32_t
+
+static long escalar(thash h, const char * texto, size_t tamanho, int busca){ // Uma linha, uma chave, uma busca
+    const char * p = texto, * fim = texto + tamanho;
+    long encontrados = 0;
+    while (p < fim){
+        const char * nl = memchr(p, '\n', fim - p);
+        if (nl == NULL)
+            nl = fim;
+        uint32_t cep;
+        if (normaliza_cep(p, nl, &cep) == EXIT_SUCCESS){
+            char chave[CEP_DIGITOS + 1];
+            cep_chave(cep, chave);
+            encontrados += busca ? hash_busca(h, chave) != NULL : cep & 1;
+        }
+        p = nl + 1;
+    }
+    return encontrados;
+}
+
+static long em_lote(thash h, const char * texto, size_t tamanho, int busca){
+    static uint32_t ceps[TAM_LOTE];
+    static uint64_t malformados[TAM_LOTE / 64];
+    static char chaves[TAM_LOTE][CEP_DIGITOS + 1];
+    static const char * ponteiros[TAM_LOTE];
+    static void * regs[TAM_LOTE];
+    long encontrados = 0;
+    size_t pos = 0;
+    for (int i = 0; i < TAM_LOTE; i++)
+        ponteiros[i] = chaves[i];
+    while (pos < tamanho){
+        int n;
+        pos += normaliza_lote(texto + pos, tamanho - pos, ceps, malformados, TAM_LOTE, &n);
+        if (!busca){
+            for (int i = 0; i < n; i++)
+                encontrados += ceps[i] & 1;
+            continue;
+        }
+        for (int i = 0; i < n; i++)
+            cep_chave(ceps[i], chaves[i]);
+        hash_busca_lote(h, ponteiros, n, malformados, regs);
+        for (int i = 0; i < n; i++)
+            encontrados += regs[i] != NULL;
+    }
+    return encontrados;
+}
+
+static long em_lote_numerico(thash h, const char * texto, size_t tamanho, int busca){ // CEPs direto no busca_lote
+    static uint32_t ceps[TAM_LOTE];
+    static uint64_t malformados[TAM_LOTE / 64];
+    static void * regs[TAM_LOTE];
+    (void)h;
+    (void)busca;
+    long encontrados = 0;
+    size_t pos = 0;
+    while (pos < tamanho){
+        int n;
+        pos += normaliza_lote(texto + pos, tamanho - pos, ceps, malformados, TAM_LOTE, &n);
+        num_busca_lote(numerica, ceps, n, malformados, regs);
+        for (int i = 0; i < n; i++)
+            encontrados += regs[i] != NULL;
+    }
+    return encontrados;
+}
+
+static void mede(const char * rotulo, long (*caminho)(thash, const char *, size_t, int), thash h,
+                 const char * texto, size_t tamanho, int busca, long * resultado){
+    double melhor = 0;
+    for (int r = 0; r < NREPETICOES; r++){
+        double ini = agora_ns();
+        long encontrados = caminho(h, texto, tamanho, busca);
+        double ns = agora_ns() - ini;
+        if (r == 0 || ns < melhor)
+            melhor = ns;
+        if (*resultado < 0)
+            *resultado = encontrados;
+        assert(encontrados == *resultado); // Os dois caminhos chegam ao mesmo resultado
+    }
+    printf("%-28s: %6.2f GB/s\n", rotulo, tamanho / melhor);
+}
+
+int main(int argc, char * argv[]){
+    int n = argc > 1 ? atoi(argv[1]) : 4000000;
+    teste_normaliza();
+
+    thash h;
+    assert(constroi_dataset(&h, 6100, get_key, 0.7) == EXIT_SUCCESS);
+    assert(num_constroi(&numerica, 6100, get_key, 0.7) == EXIT_SUCCESS);
+    for (int i = 0; i < h.max; i++){
+        if (hash_registro(h, i) != NULL)
+            assert(num_insere(&numerica, hash_registro(h, i)) == EXIT_SUCCESS);
+    }
+    srand(SEED);
+    size_t tamanho;
+    char * texto = gera_consultas(h, n, &tamanho);
+    printf("%d consultas, %.1f MB de texto\n", n, tamanho / 1e6);
+
+    // Lote e escalar concordam linha a linha
+    uint32_t * ceps = malloc(sizeof(uint32_t) * n);
+    uint64_t * malformados = malloc(sizeof(uint64_t) * ((n + 63) / 64));
+    int lidas;
+    assert(normaliza_lote(texto, tamanho, ceps, malformados, n, &lidas) == tamanho && lidas == n);
+    const char * p = texto;
+    int invalidas = 0;
+    for (int i = 0; i < n; i++){
+        const char * nl = memchr(p, '\n', texto + tamanho - p);
+        uint32_t cep = 0;
+        int malformada = normaliza_cep(p, nl, &cep) == EXIT_FAILURE;
+        assert(malformada == (int)(malformados[i / 64] >> (i % 64) & 1));
+        assert(malformada || cep == ceps[i]);
+        invalidas += malformada;
+        p = nl + 1;
+    }
+    printf("%d malformadas, iguais nos dois caminhos\n", invalidas);
+
+    long so_normaliza = -1, com_busca = -1;
+    mede("Normalizacao escalar", escalar, h, texto, tamanho, 0, &so_normaliza);
+    mede("Normalizacao em lote", em_lote, h, texto, tamanho, 0, &so_normaliza);
+    mede("Escalar + hash_busca", escalar, h, texto, tamanho, 1, &com_busca);
+    mede("Lote + hash_busca_lote", em_lote, h, texto, tamanho, 1, &com_busca);
+    mede("Lote + num_busca_lote", em_lote_numerico, h, texto, tamanho, 1, &com_busca);
+    printf("%ld consultas encontradas\n", com_busca);
+
+    free(ceps);
+    free(malformados);
+    free(texto);
+    num_apaga(&numerica);
+    hash_apaga(&h);
+    return 0;
+}
@@ -0,0 +1,286 @@
+#define _GNU_SOURCE // pthread_rwlockattr_setkind_np
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "cep.h"
+
+/* Latencia de busca enquanto o dataset e recarregado: versoes.h, que monta
+   a nova versao ao lado e publica com uma troca de ponteiro, contra
+   hash_apaga + constroi_dataset atras de uma trava de leitura/escrita, em
+   que os leitores esperam a recarga inteira. A copia do CSV alterna com
+   o original e muda a cidade de 1 linha em 10, entao ~90% dos registros
+   sao compartilhados entre versoes. Com uma CPU so, a recarga e os
+   leitores se revezam e a latencia maxima e a fatia do escalonador nos
+   dois casos; a contagem de buscas que esperaram a recarga nao depende
+   disso.
+   Uso: gcc -O2 -pthread -o bench_recarga bench_recarga.c && ./bench_recarga [recargas] */
+
+#define HT_CHAVE(h, reg)    (((tcep *)(reg))->cep_ini)
+#include "hash_tabela.h"
+#include "dataset.h"
+#include "versoes.h"
+
+#define NLEITORES       2
+#define PAUSA_US        20000  // entre recargas
+#define LARGURA_FAIXA   10     // ns por faixa do histograma
+#define NFAIXAS         100000 // ate 1 ms; acima disso so conta na ultima faixa e no maximo
+#define MODO_VERSOES    0
+#define MODO_TRAVA      1
+
+static double agora_ns(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/* ESTADO COMPARTILHADO */
+
+typedef struct {
+     pthread_t thread;
+     unsigned semente;
+     long hist[2][NFAIXAS]; // [fora/durante a recarga]
+     long nops[2];
+     double max_ns[2];
+     long faltas; // buscas por chaves do dataset que nao acharam nada
+     long esperas; // buscas que ficaram paradas esperando a recarga
+}tleitor;
+
+static int modo;
+static tversionada versionada;
+static thash travada;
+static pthread_rwlock_t trava;
+static _Atomic int parar;
+static _Atomic int recarregando;
+static char ** chaves;
+static int nchaves;
+
+/* TESTES */
+
+static void teste_versoes(const char * alterado){
+    tversionada v;
+    trecarga r;
+    assert(versao_cria(&v, "ceps.csv", 0.7) == EXIT_SUCCESS);
+    tversao * x = versao_adquire(&v);
+    assert((uintptr_t)x % _Alignof(tversao) == 0 && (uintptr_t)&x->refs % 64 == 0); // refs sozinho na linha de cache
+    tcep * velho = versao_busca(x, "69945"); // Primeira linha do CSV, alterada na copia
+    assert(velho != NULL && velho->cidade[0] != '*');
+
+    assert(versao_recarrega(&v, alterado, &r) == EXIT_SUCCESS);
+    assert(r.registros == x->h.size && r.novos > 0 && r.compartilhados > 4 * r.novos); // Chaves repetidas tambem viram registro novo
+    tversao * y = versao_adquire(&v);
+    assert(y != x && y->numero == x->numero + 1 && atomic_load(&versoes_vivas) == 2);
+    assert(versao_busca(y, "69945")->cidade[0] == '*');
+    assert(velho->cidade[0] != '*' && versao_busca(x, "69945") == velho); // A versao segurada nao muda
+
+    versao_solta(x); // Ultimo leitor da versao velha: aposenta
+    assert(atomic_load(&versoes_vivas) == 1);
+    assert(versao_recarrega(&v, "/nao/existe.csv", &r) == EXIT_FAILURE);
+    assert(atomic_load(&v.atual) == y); // Falha na recarga mantem a versao publicada
+    versao_solta(y);
+    versao_apaga(&v);
+    assert(atomic_load(&versoes_vivas) == 0 && atomic_load(&registros_vivos) == 0);
+    printf("Teste de versoes concluido\n");
+}
+
+/* LEITORES */
+
+static void * leitor(void * arg){
+    tleitor * l = (tleitor *)arg;
+    volatile char descarte = 0;
+    while (!atomic_load(&parar)){
+        const char * chave = chaves[rand_r(&l->semente) % nchaves];
+        int durante = atomic_load(&recarregando);
+        double ini = agora_ns();
+        tcep * r;
+        if (modo == MODO_VERSOES){
+            tversao * x = versao_adquire(&versionada);
+            r = versao_busca(x, chave);
+            if (r != NULL)
+                descarte += r->cidade[0];
+            versao_solta(x);
+        }
+        else {
+            if (pthread_rwlock_tryrdlock(&trava) != 0){
+                l->esperas++;
+                pthread_rwlock_rdlock(&trava);
+            }
+            r = (tcep *)hash_busca(travada, chave);
+            if (r != NULL)
+                descarte += r->cidade[0];
+            pthread_rwlock_unlock(&trava);
+        }
+        double ns = agora_ns() - ini;
+        durante |= atomic_load(&recarregando);
+        long faixa = (long)(ns / LARGURA_FAIXA);
+        l->hist[durante][faixa < NFAIXAS ? faixa : NFAIXAS - 1]++;
+        l->nops[durante]++;
+        if (ns > l->max_ns[durante])
+            l->max_ns[durante] = ns;
+        l->faltas += r == NULL;
+    }
+    (void)descarte;
+    return NULL;
+}
+
+/* RELATORIO */
+
+static double percentil(long * hist, long n, double p){
+    long alvo = (long)(p * n), acumulado = 0;
+    for (int i = 0; i < NFAIXAS; i++){
+        acumulado += hist[i];
+        if (acumulado > alvo)
+            return (i + 1) * LARGURA_FAIXA;
+    }
+    return NFAIXAS * LARGURA_FAIXA;
+}
+
+static void imprime(tleitor * leitores){
+    static long hist[NFAIXAS];
+    const char * rotulos[2] = {"fora da recarga", "durante a recarga"};
+    long faltas = 0, esperas = 0;
+    for (int i = 0; i < NLEITORES; i++){
+        faltas += leitores[i].faltas;
+        esperas += leitores[i].esperas;
+    }
+    for (int d = 0; d < 2; d++){
+        long n = 0;
+        double max = 0;
+        memset(hist, 0, sizeof(hist));
+        for (int i = 0; i < NLEITORES; i++){
+            for (int f = 0; f < NFAIXAS; f++)
+                hist[f] += leitores[i].hist[d][f];
+            n += leitores[i].nops[d];
+            if (leitores[i].max_ns[d] > max)
+                max = leitores[i].max_ns[d];
+        }
+        if (n == 0){
+            printf("  %-18s: nenhuma busca\n", rotulos[d]);
+            continue;
+        }
+        printf("  %-18s: %9ld buscas, p50 %6.0f ns, p99 %7.0f ns, p99.9 %8.0f ns, max %9.0f ns\n", rotulos[d], n,
+               percentil(hist, n, 0.5), percentil(hist, n, 0.99), percentil(hist, n, 0.999), max);
+    }
+    printf("  buscas sem resultado: %ld, buscas que esperaram a recarga: %ld\n", faltas, esperas);
+}
+
+/* RODADAS */
+
+static void rodada(int m, int nrecargas, const char * alterado){
+    modo = m;
+    atomic_store(&parar, 0);
+    tleitor * leitores = calloc(NLEITORES, sizeof(tleitor));
+    for (int i = 0; i < NLEITORES; i++){
+        leitores[i].semente = SEED + i;
+        pthread_create(&leitores[i].thread, NULL, leitor, &leitores[i]);
+    }
+    double total_ns = 0, max_ns = 0;
+    size_t extra = 0, extra_max = 0;
+    long compartilhados = 0, novos = 0;
+    for (int i = 0; i < nrecargas; i++){
+        usleep(PAUSA_US);
+        atomic_store(&recarregando, 1);
+        double ini = agora_ns();
+        if (m == MODO_VERSOES){
+            trecarga r;
+            assert(versao_recarrega(&versionada, i % 2 == 0 ? alterado : "ceps.csv", &r) == EXIT_SUCCESS);
+            extra += r.bytes_extra;
+            if (r.bytes_extra > extra_max)
+                extra_max = r.bytes_extra;
+            compartilhados += r.compartilhados;
+            novos += r.novos;
+        }
+        else {
+            pthread_rwlock_wrlock(&trava);
+            hash_apaga(&travada);
+            assert(constroi_dataset(&travada, 6100, get_key, 0.7) == EXIT_SUCCESS);
+            pthread_rwlock_unlock(&trava);
+        }
+        double ns = agora_ns() - ini;
+        atomic_store(&recarregando, 0);
+        total_ns += ns;
+        if (ns > max_ns)
+            max_ns = ns;
+    }
+    usleep(PAUSA_US);
+    atomic_store(&parar, 1);
+    for (int i = 0; i < NLEITORES; i++)
+        pthread_join(leitores[i].thread, NULL);
+
+    printf("%s: %d recargas, media %.2f ms, maior %.2f ms\n",
+           m == MODO_VERSOES ? "Versoes com troca atomica" : "hash_apaga + constroi_dataset com trava",
+           nrecargas, total_ns / nrecargas / 1e6, max_ns / 1e6);
+    if (m == MODO_VERSOES){
+        tversao * x = versao_adquire(&versionada);
+        size_t inteira = sizeof(uintptr_t) * x->h.max + sizeof(tcep_versao) * x->h.size;
+        printf("  memoria extra por recarga: media %.1f KB, maior %.1f KB (versao inteira: %.1f KB), %.1f%% dos registros compartilhados\n",
+               extra / 1e3 / nrecargas, extra_max / 1e3, inteira / 1e3, 100.0 * compartilhados / (compartilhados + novos));
+        versao_solta(x);
+        assert(atomic_load(&versoes_vivas) == 1); // Todas as versoes velhas foram aposentadas
+    }
+    imprime(leitores);
+    free(leitores);
+}
+
+/* ARQUIVO ALTERADO */
+
+static void grava_alterado(const char * caminho){
+    // Copia do ceps.csv com a cidade de 1 linha em 10 trocada, a primeira inclusive
+    FILE * entrada = fopen("ceps.csv", "r");
+    FILE * saida = fopen(caminho, "w");
+    assert(entrada != NULL && saida != NULL);
+    char line[256];
+    assert(fgets(line, sizeof(line), entrada) != NULL);
+    fputs(line, saida);
+    for (int i = 0; fgets(line, sizeof(line), entrada); i++){
+        int virgula = strcspn(line, ",");
+        if (i % 10 == 0 && line[virgula] == ',')
+            fprintf(saida, "%.*s,*%s", virgula, line, line + virgula + 1);
+        else
+            fputs(line, saida);
+    }
+    fclose(entrada);
+    fclose(saida);
+}
+
+int main(int argc, char * argv[]){
+    int nrecargas = argc > 1 ? atoi(argv[1]) : 50;
+    char alterado[] = "/tmp/ceps_alteradoXXXXXX";
+    int fd = mkstemp(alterado);
+    assert(fd >= 0);
+    close(fd);
+    grava_alterado(alterado);
+    teste_versoes(alterado);
+
+    // Chaves consultadas: todas as do dataset, presentes nas duas versoes
+    assert(constroi_dataset(&travada, 6100, get_key, 0.7) == EXIT_SUCCESS);
+    chaves = malloc(sizeof(char *) * travada.size);
+    for (int i = 0; i < travada.max; i++){
+        tcep * r = (tcep *)hash_registro(travada, i);
+        if (r != NULL)
+            chaves[nchaves++] = strdup(r->cep_ini);
+    }
+
+    pthread_rwlockattr_t atributos;
+    pthread_rwlockattr_init(&atributos);
+    pthread_rwlockattr_setkind_np(&atributos, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP); // Senao a recarga espera para sempre
+    pthread_rwlock_init(&trava, &atributos);
+    rodada(MODO_TRAVA, nrecargas, alterado);
+    pthread_rwlock_destroy(&trava);
+    hash_apaga(&travada);
+
+    assert(versao_cria(&versionada, "ceps.csv", 0.7) == EXIT_SUCCESS);
+    rodada(MODO_VERSOES, nrecargas, alterado);
+    versao_apaga(&versionada);
+    assert(atomic_load(&versoes_vivas) == 0 && atomic_load(&registros_vivos) == 0);
+
+    for (int i = 0; i < nchaves; i++)
+        free(chaves[i]);
+    free(chaves);
+    unlink(alterado);
+    return 0;
+}
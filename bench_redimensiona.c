@@ -0,0 +1,110 @@
+#ifndef CEP_DIGITOS
+#define CEP_DIGITOS 8 // Chaves distintas para milhoes de registros
+#endif
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include "cep.h"
+
+/* Mede o custo de duplicar a tabela com e sem HT_GUARDA_HASH. Sem o hash
+   guardado, duplicar le a chave de cada registro e recalcula o hash; com ele,
+   so percorre os slots. Tambem mede a memoria da tabela por registro e a
+   busca, que com o hash guardado descarta slots sem chamar strcmp.
+   Uso: bench_redimensiona [registros] */
+
+#define HT_PREFIXO          lin
+#define HT_TIPO             tlin
+#define HT_SONDAGEM         HT_LINEAR
+#define HT_CHAVE(h, reg)    (((tcep *)(reg))->cep_ini)
+#define HT_LIBERA(reg)      (void)(reg)
+#include "hash_tabela.h"
+
+#define HT_PREFIXO          lin_guardado
+#define HT_TIPO             tlin_guardado
+#define HT_SONDAGEM         HT_LINEAR
+#define HT_CHAVE(h, reg)    (((tcep *)(reg))->cep_ini)
+#define HT_LIBERA(reg)      (void)(reg)
+#define HT_GUARDA_HASH
+#include "hash_tabela.h"
+
+#define HT_PREFIXO          dup
+#define HT_TIPO             tdup
+#define HT_SONDAGEM         HT_DUPLA
+#define HT_CHAVE(h, reg)    (((tcep *)(reg))->cep_ini)
+#define HT_LIBERA(reg)      (void)(reg)
+#include "hash_tabela.h"
+
+#define HT_PREFIXO          dup_guardado
+#define HT_TIPO             tdup_guardado
+#define HT_SONDAGEM         HT_DUPLA
+#define HT_CHAVE(h, reg)    (((tcep *)(reg))->cep_ini)
+#define HT_LIBERA(reg)      (void)(reg)
+#define HT_GUARDA_HASH
+#include "hash_tabela.h"
+
+static double agora_ms(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e3 + t.tv_nsec / 1e6;
+}
+
+/* Carrega n registros numa tabela que termina proxima da taxa, mede um
+   duplicar e confere que todos continuam acessiveis depois dele */
+#define MEDE(prefixo, tipo, rotulo, escala) do {                                            \
+    tipo t;                                                                                 \
+    assert(prefixo##_constroi(&t, (int)(n / taxa) + 2, get_key, taxa + 0.01) == EXIT_SUCCESS); \
+    for (int i = 0; i < n; i++)                                                             \
+        prefixo##_insere(&t, &regs[i]);                                                     \
+    double bytes = (double)sizeof(uintptr_t) * (escala) * t.max / t.size;                   \
+    double ini = agora_ms();                                                                \
+    for (int i = 0; i < n; i++)                                                             \
+        encontrados += prefixo##_busca(t, regs[i].cep_ini) != NULL;                         \
+    double t_busca = agora_ms() - ini;                                                      \
+    ini = agora_ms();                                                                       \
+    for (int i = 0; i < n; i++)                                                             \
+        encontrados += prefixo##_busca(t, ausentes[i]) != NULL;                             \
+    double t_falha = agora_ms() - ini;                                                      \
+    ini = agora_ms();                                                                       \
+    int dobrou = prefixo##_duplicar(&t);                                                    \
+    double t_duplicar = agora_ms() - ini;                                                   \
+    assert(dobrou == EXIT_SUCCESS);                                                         \
+    for (int i = 0; i < n; i++)                                                             \
+        assert(prefixo##_busca(t, regs[i].cep_ini) != NULL);                                \
+    printf("Taxa %2.0f%% %-13s: duplicar %8.2f ms (%5.1f ns/reg), %5.1f bytes/reg, acerto %5.1f ns, falha %5.1f ns\n", \
+           taxa * 100, rotulo, t_duplicar, t_duplicar * 1e6 / n, bytes,                    \
+           t_busca * 1e6 / n, t_falha * 1e6 / n);                                           \
+    prefixo##_apaga(&t);                                                                    \
+} while (0)
+
+int main(int argc, char * argv[]){
+    int n = argc > 1 ? atoi(argv[1]) : 2000000;
+    float taxas[] = {0.1, 0.3, 0.5, 0.7, 0.9};
+
+    // Registros com cep_ini distintos (i * 7919 mod 10^8 e uma permutacao) e chaves ausentes
+    tcep * regs = malloc(sizeof(tcep) * n);
+    char (*ausentes)[CEP_DIGITOS + 1] = malloc(sizeof(*ausentes) * n);
+    for (int i = 0; i < n; i++){
+        long chave = ((long)i * 7919) % 100000000L;
+        memset(&regs[i], 0, sizeof(tcep));
+        snprintf(regs[i].cep_ini, sizeof(regs[i].cep_ini), "%08ld", chave);
+        snprintf(regs[i].cep_fim, sizeof(regs[i].cep_fim), "%08ld", chave);
+        snprintf(ausentes[i], sizeof(ausentes[i]), "%08ld", ((long)(i + n) * 7919) % 100000000L);
+    }
+
+    printf("Duplicar com e sem hash guardado (%d registros)...\n", n);
+    long encontrados = 0;
+    for (int k = 0; k < (int)(sizeof(taxas) / sizeof(taxas[0])); k++){
+        float taxa = taxas[k];
+        MEDE(lin, tlin, "linear", 1);
+        MEDE(lin_guardado, tlin_guardado, "linear+hash", 2);
+        MEDE(dup, tdup, "dupla", 1);
+        MEDE(dup_guardado, tdup_guardado, "dupla+hash", 2);
+    }
+    assert(encontrados == 20L * n); // So as chaves presentes
+    free(regs);
+    free(ausentes);
+    return 0;
+}
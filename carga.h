@@ -0,0 +1,250 @@
+#ifndef CARGA_H
+#define CARGA_H
+
+/* CARGA EM PIPELINE
+   Tres estagios ligados por aneis SPSC sem trava: uma thread leitora faz
+   read() em blocos grandes, uma thread de parse transforma linhas em lotes
+   de tcep e a thread chamadora insere na tabela. Cada ligacao tem dois
+   aneis (cheios e livres), entao os buffers circulam sem malloc e a leitura
+   do proximo bloco acontece enquanto o anterior e processado.
+   Usa a tabela e o dataset incluidos antes deste arquivo. Compilar com -pthread. */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include "cep.h"
+
+#define TAM_BLOCO_CARGA (1 << 20) // bytes por leitura
+#define TAM_LOTE_CARGA  1024      // registros por lote
+#define NBUFFERS_CARGA  4         // buffers em circulacao em cada ligacao, potencia de 2
+
+/* ESTRUTURA DO ANEL SPSC */
+
+typedef struct {
+     _Alignas(64) _Atomic size_t cabeca; // proxima posicao a escrever, so o produtor altera
+     _Alignas(64) _Atomic size_t cauda; // proxima posicao a ler, so o consumidor altera
+     void * itens[NBUFFERS_CARGA];
+}tanel;
+
+/* FUNCOES DO ANEL SPSC */
+
+static inline void anel_inicia(tanel * a){
+    atomic_init(&a->cabeca, 0);
+    atomic_init(&a->cauda, 0);
+}
+
+static inline void anel_poe(tanel * a, void * item){ // Espera vaga; o anel nunca tem mais itens que buffers
+    size_t cabeca = atomic_load_explicit(&a->cabeca, memory_order_relaxed);
+    while (cabeca - atomic_load_explicit(&a->cauda, memory_order_acquire) == NBUFFERS_CARGA)
+        sched_yield();
+    a->itens[cabeca % NBUFFERS_CARGA] = item;
+    atomic_store_explicit(&a->cabeca, cabeca + 1, memory_order_release);
+}
+
+static inline void * anel_tira(tanel * a){ // Espera um item
+    size_t cauda = atomic_load_explicit(&a->cauda, memory_order_relaxed);
+    while (atomic_load_explicit(&a->cabeca, memory_order_acquire) == cauda)
+        sched_yield();
+    void * item = a->itens[cauda % NBUFFERS_CARGA];
+    atomic_store_explicit(&a->cauda, cauda + 1, memory_order_release);
+    return item;
+}
+
+/* ESTRUTURA DA CARGA */
+
+typedef struct {
+     char dados[TAM_BLOCO_CARGA + 1]; // +1 para o '\n' final de arquivo sem quebra
+     size_t tamanho; // 0 = fim do arquivo
+}tbloco_carga;
+
+typedef struct {
+     tcep regs[TAM_LOTE_CARGA];
+     int n; // -1 = fim da carga
+}tlote_carga;
+
+typedef struct {
+     int fd;
+     tanel blocos_cheios, blocos_livres;
+     tanel lotes_cheios, lotes_livres;
+     tbloco_carga * blocos;
+     tlote_carga * lotes;
+     size_t bytes; // lidos pelo estagio de leitura
+     int erro; // errno do read que falhou, 0 = sem erro; lido so depois do join
+     _Atomic int parar; // a carga desistiu: o leitor encerra no proximo bloco
+}tcarga;
+
+/* ESTAGIOS DA CARGA */
+
+static inline void * carga_leitor(void * arg){
+    tcarga * c = (tcarga *)arg;
+    size_t sobra = 0; // linha incompleta no fim do bloco anterior
+    char resto[TAM_BLOCO_CARGA];
+    for (;;){
+        tbloco_carga * b = (tbloco_carga *)anel_tira(&c->blocos_livres);
+        if (atomic_load(&c->parar)){
+            b->tamanho = 0;
+            anel_poe(&c->blocos_cheios, b);
+            return NULL;
+        }
+        memcpy(b->dados, resto, sobra);
+        size_t lido = sobra;
+        while (lido < TAM_BLOCO_CARGA){
+            ssize_t r = read(c->fd, b->dados + lido, TAM_BLOCO_CARGA - lido);
+            if (r > 0)
+                lido += r;
+            else if (r < 0 && errno == EINTR)
+                continue;
+            else { // Fim do arquivo ou erro; com erro a carga falha, mas o pipeline encerra igual
+                if (r < 0)
+                    c->erro = errno;
+                break;
+            }
+        }
+        c->bytes += lido - sobra;
+        if (lido < TAM_BLOCO_CARGA){ // Fim do arquivo, entrega tudo
+            if (lido > 0 && b->dados[lido - 1] != '\n')
+                b->dados[lido++] = '\n';
+            b->tamanho = lido;
+            anel_poe(&c->blocos_cheios, b);
+            if (lido > 0){
+                b = (tbloco_carga *)anel_tira(&c->blocos_livres);
+                b->tamanho = 0;
+                anel_poe(&c->blocos_cheios, b);
+            }
+            return NULL;
+        }
+        // Entrega ate a ultima quebra de linha e guarda o resto
+        size_t fim = lido;
+        while (fim > 0 && b->dados[fim - 1] != '\n')
+            fim--;
+        if (fim == 0) // Linha maior que o bloco, descarta
+            fim = lido;
+        sobra = lido - fim;
+        memcpy(resto, b->dados + fim, sobra);
+        b->tamanho = fim;
+        anel_poe(&c->blocos_cheios, b);
+    }
+}
+
+static inline void * carga_parser(void * arg){
+    tcarga * c = (tcarga *)arg;
+    int cabecalho = 1;
+    tlote_carga * l = (tlote_carga *)anel_tira(&c->lotes_livres);
+    l->n = 0;
+    for (;;){
+        tbloco_carga * b = (tbloco_carga *)anel_tira(&c->blocos_cheios);
+        if (b->tamanho == 0){
+            anel_poe(&c->blocos_livres, b);
+            break;
+        }
+        char * p = b->dados;
+        char * fim = b->dados + b->tamanho;
+        while (p < fim){
+            char * q = memchr(p, '\n', fim - p);
+            if (q == NULL) // Linha cortada pelo leitor
+                break;
+            *q = '\0';
+            if (cabecalho)
+                cabecalho = 0;
+            else if (le_linha_cep(p, &l->regs[l->n]) == EXIT_SUCCESS && ++l->n == TAM_LOTE_CARGA){
+                anel_poe(&c->lotes_cheios, l);
+                l = (tlote_carga *)anel_tira(&c->lotes_livres);
+                l->n = 0;
+            }
+            p = q + 1;
+        }
+        anel_poe(&c->blocos_livres, b);
+    }
+    if (l->n > 0){
+        anel_poe(&c->lotes_cheios, l);
+        l = (tlote_carga *)anel_tira(&c->lotes_livres);
+    }
+    l->n = -1;
+    anel_poe(&c->lotes_cheios, l);
+    return NULL;
+}
+
+/* FUNCOES DA CARGA */
+
+static inline int carga_pipeline(thash * h, const char * caminho){ // Mesmo resultado de ler_CSV, com leitura e parse em paralelo
+    tcarga * c = (tcarga *)calloc(1, sizeof(tcarga));
+    if (c == NULL)
+        return EXIT_FAILURE;
+    c->fd = open(caminho, O_RDONLY);
+    c->blocos = (tbloco_carga *)malloc(sizeof(tbloco_carga) * NBUFFERS_CARGA);
+    c->lotes = (tlote_carga *)malloc(sizeof(tlote_carga) * NBUFFERS_CARGA);
+    if (c->fd < 0 || c->blocos == NULL || c->lotes == NULL){
+        fprintf(stderr, "Erro ao abrir o arquivo %s\n", caminho);
+        if (c->fd >= 0)
+            close(c->fd);
+        free(c->blocos);
+        free(c->lotes);
+        free(c);
+        return EXIT_FAILURE;
+    }
+    posix_fadvise(c->fd, 0, 0, POSIX_FADV_SEQUENTIAL); // Leitura antecipada maior pelo kernel
+    anel_inicia(&c->blocos_cheios);
+    anel_inicia(&c->blocos_livres);
+    anel_inicia(&c->lotes_cheios);
+    anel_inicia(&c->lotes_livres);
+    for (int i = 0; i < NBUFFERS_CARGA; i++){
+        anel_poe(&c->blocos_livres, &c->blocos[i]);
+        anel_poe(&c->lotes_livres, &c->lotes[i]);
+    }
+
+    int resultado = EXIT_SUCCESS;
+    pthread_t leitor, parser;
+    if (pthread_create(&leitor, NULL, carga_leitor, c) != 0){
+        fprintf(stderr, "Erro ao criar a thread de leitura\n");
+        resultado = EXIT_FAILURE;
+    }
+    else if (pthread_create(&parser, NULL, carga_parser, c) != 0){
+        // Sem parser ninguem esvazia os blocos: para o leitor e escoa ate o fim
+        fprintf(stderr, "Erro ao criar a thread de parse\n");
+        atomic_store(&c->parar, 1);
+        for (;;){
+            tbloco_carga * b = (tbloco_carga *)anel_tira(&c->blocos_cheios);
+            size_t tamanho = b->tamanho;
+            anel_poe(&c->blocos_livres, b);
+            if (tamanho == 0)
+                break;
+        }
+        pthread_join(leitor, NULL);
+        resultado = EXIT_FAILURE;
+    }
+    else {
+        for (;;){ // Estagio de insercao na thread chamadora
+            tlote_carga * l = (tlote_carga *)anel_tira(&c->lotes_cheios);
+            if (l->n < 0)
+                break;
+            for (int i = 0; i < l->n && resultado == EXIT_SUCCESS; i++){
+                if (insere_cep(h, &l->regs[i]) == EXIT_FAILURE){ // Para de inserir, mas escoa os lotes
+                    resultado = EXIT_FAILURE;
+                    atomic_store(&c->parar, 1);
+                }
+            }
+            anel_poe(&c->lotes_livres, l);
+        }
+        pthread_join(leitor, NULL);
+        pthread_join(parser, NULL);
+        if (c->erro != 0){ // Tabela truncada nao conta como carga completa
+            fprintf(stderr, "Erro ao ler %s: %s\n", caminho, strerror(c->erro));
+            resultado = EXIT_FAILURE;
+        }
+    }
+
+    close(c->fd);
+    free(c->blocos);
+    free(c->lotes);
+    free(c);
+    return resultado;
+}
+
+#endif
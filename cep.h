@@ -0,0 +1,38 @@
+#ifndef CEP_H
+#define CEP_H
+
+#include <stdlib.h>
+#include <string.h>
+#include "alocacao.h"
+
+#ifndef CEP_DIGITOS
+#define CEP_DIGITOS 5 // Digitos da chave; o ceps.csv tem 8, os testes usam os 5 primeiros
+#endif
+
+/* ESTRUTURA DOS CEPS */
+
+typedef struct {
+    char cep_ini[CEP_DIGITOS + 1];
+    char cep_fim[CEP_DIGITOS + 1];
+    char cidade[50];
+    char estado[3];
+} tcep;
+
+/* FUNCOES ESTRUTURA CEP */
+
+static inline char * get_key(void * reg){
+    return ((tcep *)reg)->cep_ini;
+}
+
+static inline void * aloca_cep(char * cep_ini, char *cep_fim, char * cidade, char * estado){
+    tcep *_cep = (tcep *)malloc(sizeof(tcep));
+    if (_cep == NULL)
+        return NULL;
+    strcpy(_cep->cep_ini,cep_ini);
+    strcpy(_cep->cep_fim,cep_fim);
+    strcpy(_cep->cidade,cidade);
+    strcpy(_cep->estado,estado);
+    return _cep;
+}
+
+#endif
@@ -0,0 +1,272 @@
+#ifndef CEP_INDICE_H
+#define CEP_INDICE_H
+
+/* INDICE ORDENADO DE CEPS
+   Trie de digitos sobre cep_ini. Os CEPs tem tamanho fixo, entao a ordem
+   da trie e a ordem numerica e cada consulta custa O(digitos + k).
+   Cada no guarda o maior cep_fim da subarvore. Na busca por faixas que se
+   sobrepoem a [a, b] so os nos no caminho de a e de b sao conferidos; as
+   subarvores entre eles saem inteiras e as anteriores a a so descem onde
+   max_fim chega em a. */
+
+#include <stdlib.h>
+#include <string.h>
+#include "cep.h"
+
+#define MAX_DIGITOS_INDICE 16
+
+/* ESTRUTURA DO INDICE */
+
+typedef struct tno_indice {
+     struct tno_indice * filhos[10];
+     int fim_filhos[10]; // max_fim de cada filho, -1 se vazio: poda sem ler o filho
+     tcep ** regs; // registros com exatamente esta chave
+     int nregs;
+     int capregs;
+     int max_fim; // maior cep_fim na subarvore, -1 se vazia
+     int total; // registros na subarvore
+     tcep * unico; // o registro da subarvore quando total == 1, sem descer ate ele
+}tno_indice;
+
+typedef struct {
+     tno_indice * raiz;
+}tindice;
+
+/* FUNCOES DO INDICE */
+
+static inline tno_indice * indice_novo_no(){
+    tno_indice * no = (tno_indice *)calloc(1, sizeof(tno_indice));
+    if (no != NULL){
+        no->max_fim = -1;
+        for (int d = 0; d < 10; d++)
+            no->fim_filhos[d] = -1;
+    }
+    return no;
+}
+
+static inline tindice * indice_cria(){
+    tindice * ind = (tindice *)malloc(sizeof(tindice));
+    if (ind == NULL)
+        return NULL;
+    ind->raiz = indice_novo_no();
+    if (ind->raiz == NULL){
+        free(ind);
+        return NULL;
+    }
+    return ind;
+}
+
+static inline int indice_digito(char c){
+    return (c >= '0' && c <= '9') ? c - '0' : -1;
+}
+
+static inline int indice_insere(tindice * ind, tcep * reg){ // EXIT_FAILURE so sem memoria, e entao o indice fica como estava
+    if (ind == NULL)
+        return EXIT_SUCCESS;
+    int n = 0;
+    for (; reg->cep_ini[n]; n++){
+        if (indice_digito(reg->cep_ini[n]) < 0 || n >= MAX_DIGITOS_INDICE)
+            return EXIT_SUCCESS; // Chave que nao e CEP fica fora do indice de proposito
+    }
+    tno_indice * no = ind->raiz;
+    for (int i = 0; i < n; i++){ // Cria o caminho antes de contar o registro
+        int d = indice_digito(reg->cep_ini[i]);
+        if (no->filhos[d] == NULL && (no->filhos[d] = indice_novo_no()) == NULL)
+            return EXIT_FAILURE;
+        no = no->filhos[d];
+    }
+    if (no->nregs == no->capregs){
+        int cap = no->capregs ? 2 * no->capregs : 1;
+        tcep ** regs = (tcep **)realloc(no->regs, sizeof(tcep *) * cap);
+        if (regs == NULL)
+            return EXIT_FAILURE;
+        no->regs = regs;
+        no->capregs = cap;
+    }
+    no->regs[no->nregs++] = reg;
+    int fim = atoi(reg->cep_fim);
+    no = ind->raiz;
+    for (int i = 0; ; i++){
+        no->total++;
+        no->unico = no->total == 1 ? reg : NULL;
+        if (fim > no->max_fim)
+            no->max_fim = fim;
+        if (i == n)
+            break;
+        int d = indice_digito(reg->cep_ini[i]);
+        if (fim > no->fim_filhos[d])
+            no->fim_filhos[d] = fim;
+        no = no->filhos[d];
+    }
+    return EXIT_SUCCESS;
+}
+
+static inline void indice_recalcula(tno_indice * no){ // max_fim e unico a partir dos registros e dos filhos
+    no->max_fim = -1;
+    no->unico = NULL;
+    for (int i = 0; i < no->nregs; i++){
+        int fim = atoi(no->regs[i]->cep_fim);
+        if (fim > no->max_fim)
+            no->max_fim = fim;
+    }
+    for (int d = 0; d < 10; d++){
+        if (no->fim_filhos[d] > no->max_fim)
+            no->max_fim = no->fim_filhos[d];
+        if (no->total == 1 && no->fim_filhos[d] >= 0)
+            no->unico = no->filhos[d]->unico;
+    }
+    if (no->total == 1 && no->nregs == 1)
+        no->unico = no->regs[0];
+}
+
+static inline int indice_remove(tindice * ind, tcep * reg){ // Remove este registro (por endereco)
+    if (ind == NULL)
+        return EXIT_SUCCESS;
+    tno_indice * caminho[MAX_DIGITOS_INDICE + 1];
+    int n = 0;
+    tno_indice * no = ind->raiz;
+    for (const char * p = reg->cep_ini; no != NULL; p++){
+        if (n > MAX_DIGITOS_INDICE)
+            return EXIT_FAILURE;
+        caminho[n++] = no;
+        if (*p == '\0')
+            break;
+        int d = indice_digito(*p);
+        no = d < 0 ? NULL : no->filhos[d];
+    }
+    if (no == NULL)
+        return EXIT_FAILURE;
+    int i;
+    for (i = 0; i < no->nregs && no->regs[i] != reg; i++)
+        ;
+    if (i == no->nregs)
+        return EXIT_FAILURE;
+    no->regs[i] = no->regs[--no->nregs];
+    for (int k = n - 1; k >= 0; k--){ // Atualiza do no da chave ate a raiz
+        caminho[k]->total--;
+        indice_recalcula(caminho[k]);
+        if (k > 0)
+            caminho[k - 1]->fim_filhos[indice_digito(reg->cep_ini[k - 1])] = caminho[k]->max_fim;
+    }
+    return EXIT_SUCCESS;
+}
+
+static inline void indice_apaga_no(tno_indice * no){
+    if (no == NULL)
+        return;
+    for (int d = 0; d < 10; d++)
+        indice_apaga_no(no->filhos[d]);
+    free(no->regs);
+    free(no);
+}
+
+static inline void indice_apaga(tindice * ind){
+    if (ind == NULL)
+        return;
+    indice_apaga_no(ind->raiz);
+    free(ind);
+}
+
+static inline int indice_visita_no(tno_indice * no, void (*visita)(tcep *, void *), void * ctx){
+    if (no->total == 1){
+        if (visita != NULL)
+            visita(no->unico, ctx);
+        return 1;
+    }
+    int n = 0;
+    for (int i = 0; i < no->nregs; i++){
+        if (visita != NULL)
+            visita(no->regs[i], ctx);
+        n++;
+    }
+    for (int d = 0; d < 10; d++){
+        if (no->fim_filhos[d] >= 0)
+            n += indice_visita_no(no->filhos[d], visita, ctx);
+    }
+    return n;
+}
+
+static inline int indice_prefixo(tindice * ind, const char * prefixo, void (*visita)(tcep *, void *), void * ctx){
+    /* Visita em ordem os registros cujo cep_ini comeca com prefixo, devolve quantos */
+    tno_indice * no = ind->raiz;
+    for (const char * p = prefixo; *p && no != NULL; p++){
+        int d = indice_digito(*p);
+        no = d < 0 ? NULL : no->filhos[d];
+    }
+    if (no == NULL)
+        return 0;
+    return indice_visita_no(no, visita, ctx);
+}
+
+static inline int indice_chega_em(tno_indice * no, int a_num, void (*visita)(tcep *, void *), void * ctx){
+    /* Subarvore com todo cep_ini abaixo de a: so as faixas que chegam em a.
+       max_fim leva direto a elas, entao o custo acompanha o resultado */
+    if (no->total == 1){ // O chamador ja viu que max_fim chega em a
+        if (visita != NULL)
+            visita(no->unico, ctx);
+        return 1;
+    }
+    int n = 0;
+    for (int i = 0; i < no->nregs; i++){
+        if (atoi(no->regs[i]->cep_fim) >= a_num){
+            if (visita != NULL)
+                visita(no->regs[i], ctx);
+            n++;
+        }
+    }
+    for (int d = 0; d < 10; d++){
+        if (no->fim_filhos[d] >= a_num)
+            n += indice_chega_em(no->filhos[d], a_num, visita, ctx);
+    }
+    return n;
+}
+
+static inline int indice_intervalo_no(tno_indice * no, int nivel, const char * a, const char * b, int a_num,
+                                      int borda_a, int borda_b, void (*visita)(tcep *, void *), void * ctx){
+    /* borda_a/borda_b: o prefixo do no e prefixo de a/b. Fora das bordas a
+       subarvore esta toda dentro de [a, b] e sai sem conferir registro */
+    if (!borda_a && !borda_b)
+        return indice_visita_no(no, visita, ctx);
+    int n = 0;
+    for (int i = 0; i < no->nregs; i++){
+        if (atoi(no->regs[i]->cep_fim) >= a_num && strcmp(no->regs[i]->cep_ini, b) <= 0){
+            if (visita != NULL)
+                visita(no->regs[i], ctx);
+            n++;
+        }
+    }
+    // Filhos entre os digitos de a e b neste nivel; chave mais longa que b passa de b
+    int menor = borda_a && a[nivel] != '\0' ? indice_digito(a[nivel]) : 0;
+    int maior = !borda_b ? 9 : b[nivel] != '\0' ? indice_digito(b[nivel]) : -1;
+    for (int d = 0; d <= maior; d++){
+        tno_indice * filho = no->filhos[d];
+        if (no->fim_filhos[d] < a_num) // Nenhuma faixa da subarvore chega em a
+            continue;
+        if (d < menor)
+            n += indice_chega_em(filho, a_num, visita, ctx);
+        else
+            n += indice_intervalo_no(filho, nivel + 1, a, b, a_num, borda_a && d == menor && a[nivel] != '\0',
+                                     borda_b && d == maior, visita, ctx);
+    }
+    return n;
+}
+
+static inline int indice_intervalo(tindice * ind, const char * a, const char * b, void (*visita)(tcep *, void *), void * ctx){
+    /* Visita em ordem as faixas [cep_ini, cep_fim] que se sobrepoem a [a, b].
+       a e b tem o mesmo numero de digitos das chaves. Devolve quantas */
+    if (strlen(a) > MAX_DIGITOS_INDICE || strlen(b) > MAX_DIGITOS_INDICE)
+        return 0;
+    for (const char * p = a; *p; p++){
+        if (indice_digito(*p) < 0)
+            return 0;
+    }
+    for (const char * p = b; *p; p++){
+        if (indice_digito(*p) < 0)
+            return 0;
+    }
+    if (ind->raiz->max_fim < atoi(a))
+        return 0;
+    return indice_intervalo_no(ind->raiz, 0, a, b, atoi(a), 1, 1, visita, ctx);
+}
+
+#endif
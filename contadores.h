@@ -0,0 +1,166 @@
+#ifndef CONTADORES_H
+#define CONTADORES_H
+
+/* CONTADORES DE HARDWARE E MARCAS DE FASE
+   Le ciclos, instrucoes, faltas na L1d, na LLC e no dTLB e desvios mal
+   previstos via perf_event_open (so espaco de usuario, basta
+   perf_event_paranoid <= 2), alem do tempo de CPU e das faltas de pagina.
+   Eventos que a maquina nao oferece (VMs sem PMU, por exemplo) ficam de
+   fora e aparecem como "-".
+
+   contadores_inicia/contadores_para tambem marcam a fase para profilers
+   externos: fase_inicio e fase_fim nunca sao expandidas em linha nem
+   clonadas, entao aceitam uprobes
+   (perf probe -x ./hash_sl 'fase_inicio nome=+0(%di):string'), e com
+   <sys/sdt.h> viram tambem os probes USDT hash_ceps:fase_inicio/fase_fim. */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define CONTADORES_SDT
+#endif
+#endif
+
+#define NCONTADORES 8
+
+#define CACHE_FALTA(cache) ((cache) | PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+
+static const struct {
+     const char * nome;
+     uint32_t tipo;
+     uint64_t config;
+} contadores_eventos[NCONTADORES] = {
+     {"ciclos",     PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+     {"instrucoes", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+     {"l1d",        PERF_TYPE_HW_CACHE, CACHE_FALTA(PERF_COUNT_HW_CACHE_L1D)},
+     {"llc",        PERF_TYPE_HW_CACHE, CACHE_FALTA(PERF_COUNT_HW_CACHE_LL)},
+     {"dtlb",       PERF_TYPE_HW_CACHE, CACHE_FALTA(PERF_COUNT_HW_CACHE_DTLB)},
+     {"desvios",    PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+     {"ns_cpu",     PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+     {"faltas_pag", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+};
+
+typedef struct {
+     int fd[NCONTADORES]; // -1 = evento indisponivel nesta maquina
+     double valores[NCONTADORES]; // ultima fase, corrigidos pela multiplexacao
+}tcontadores;
+
+/* MARCAS DE FASE */
+
+static const char * volatile fase_atual; // Fase em andamento, NULL fora delas; visivel num depurador
+
+__attribute__((noinline, noclone, unused)) static void fase_inicio(const char * nome){
+#ifdef CONTADORES_SDT
+    DTRACE_PROBE1(hash_ceps, fase_inicio, nome);
+#endif
+    fase_atual = nome;
+}
+
+__attribute__((noinline, noclone, unused)) static void fase_fim(const char * nome){
+#ifdef CONTADORES_SDT
+    DTRACE_PROBE1(hash_ceps, fase_fim, nome);
+#endif
+    (void)nome;
+    fase_atual = NULL;
+}
+
+/* FUNCOES DOS CONTADORES */
+
+static inline int contadores_abre(tcontadores * c){ // Abre o que a maquina oferece, devolve quantos eventos
+    int n = 0;
+    for (int i = 0; i < NCONTADORES; i++){
+        struct perf_event_attr a;
+        memset(&a, 0, sizeof(a));
+        a.type = contadores_eventos[i].tipo;
+        a.size = sizeof(a);
+        a.config = contadores_eventos[i].config;
+        a.disabled = 1;
+        a.exclude_kernel = 1;
+        a.exclude_hv = 1;
+        a.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        c->fd[i] = syscall(SYS_perf_event_open, &a, 0, -1, -1, 0); // Esta thread, qualquer CPU
+        c->valores[i] = 0;
+        n += c->fd[i] >= 0;
+    }
+    return n;
+}
+
+static inline void contadores_inicia(tcontadores * c, const char * fase){
+    fase_inicio(fase);
+    for (int i = 0; i < NCONTADORES; i++){
+        if (c->fd[i] >= 0){
+            ioctl(c->fd[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(c->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+static inline void contadores_para(tcontadores * c, const char * fase){
+    for (int i = 0; i < NCONTADORES; i++){
+        if (c->fd[i] >= 0)
+            ioctl(c->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+    fase_fim(fase);
+    for (int i = 0; i < NCONTADORES; i++){
+        uint64_t leitura[3]; // valor, tempo habilitado, tempo contando
+        c->valores[i] = -1;
+        if (c->fd[i] < 0 || read(c->fd[i], leitura, sizeof(leitura)) != sizeof(leitura))
+            continue;
+        // Com mais eventos que contadores fisicos o kernel reveza; estima o total
+        c->valores[i] = leitura[2] > 0 ? (double)leitura[0] * leitura[1] / leitura[2] : 0;
+    }
+}
+
+static inline void contadores_fecha(tcontadores * c){
+    for (int i = 0; i < NCONTADORES; i++){
+        if (c->fd[i] >= 0)
+            close(c->fd[i]);
+        c->fd[i] = -1;
+    }
+}
+
+/* RELATORIOS */
+
+static inline void contadores_cabecalho(){
+    printf("%-24s", "fase");
+    for (int i = 0; i < NCONTADORES; i++)
+        printf(" %10s", contadores_eventos[i].nome);
+    printf(" %6s\n", "IPC");
+}
+
+static inline void contadores_imprime(tcontadores * c, const char * fase, long nops){ // Valores por operacao
+    printf("%-24s", fase);
+    for (int i = 0; i < NCONTADORES; i++){
+        if (c->valores[i] < 0)
+            printf(" %10s", "-");
+        else
+            printf(" %10.3f", c->valores[i] / nops);
+    }
+    if (c->valores[0] > 0 && c->valores[1] >= 0)
+        printf(" %6.2f\n", c->valores[1] / c->valores[0]);
+    else
+        printf(" %6s\n", "-");
+}
+
+static inline void contadores_csv_cabecalho(FILE * saida){ // Colunas <evento>_op, depois das do chamador
+    for (int i = 0; i < NCONTADORES; i++)
+        fprintf(saida, ",%s_op", contadores_eventos[i].nome);
+}
+
+static inline void contadores_csv(tcontadores * c, FILE * saida, long nops){ // Coluna vazia = indisponivel
+    for (int i = 0; i < NCONTADORES; i++){
+        if (c->valores[i] < 0)
+            fprintf(saida, ",");
+        else
+            fprintf(saida, ",%.3f", c->valores[i] / nops);
+    }
+}
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+/* Carga do ceps.csv. Usa a tabela incluida antes deste arquivo
+   (thash, hash_constroi_alocacao, hash_insere, hash_registro). */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cep.h"
+
+/* FUNCOES DATASET */
+
+static inline tcep * busca_cidade_por_cep(thash h, const char * cep_consultado) {
+    // Converte CEP consultado para numero para comparacao
+    int cep_num = atoi(cep_consultado);
+
+    // Busca linear na hash (ja que nao sabemos o cep_ini exato)
+    for (int i = 0; i < h.max; i++) {
+        tcep * registro = (tcep *)hash_registro(h, i);
+        if (registro != NULL) {
+            int cep_ini_num = atoi(registro->cep_ini);
+            int cep_fim_num = atoi(registro->cep_fim);
+
+            // Verifica se o CEP esta no intervalo
+            if (cep_num >= cep_ini_num && cep_num <= cep_fim_num) {
+                return registro;
+            }
+        }
+    }
+    return NULL;
+}
+
+static inline void copia_cep(char * destino, const char * token){ // O CSV perdeu os zeros a esquerda: recoloca ate 8 digitos
+    int n = strspn(token, "0123456789");
+    int zeros = n < 8 ? 8 - n : 0;
+    for (int i = 0; i < CEP_DIGITOS; i++)
+        destino[i] = i < zeros ? '0' : i - zeros < n ? token[i - zeros] : '\0';
+}
+
+static inline int le_linha_cep(char * line, tcep * cep){ // Preenche cep com uma linha do CSV, sem alocar
+    char *resto;
+    memset(cep, 0, sizeof(tcep));
+
+    line[strcspn(line, "\r\n")] = 0;
+
+    char *token = strtok_r(line, ",", &resto);
+    if (!token) return EXIT_FAILURE;
+    strncpy(cep->estado, token, 2);
+
+    token = strtok_r(NULL, ",", &resto);
+    if (!token) return EXIT_FAILURE;
+    strncpy(cep->cidade, token, sizeof(cep->cidade) - 1);
+
+    token = strtok_r(NULL, ",", &resto); // Faixa de CEP (ignora)
+
+    token = strtok_r(NULL, ",", &resto);
+    if (!token) return EXIT_FAILURE;
+    copia_cep(cep->cep_ini, token);
+
+    token = strtok_r(NULL, ",", &resto);
+    if (!token) return EXIT_FAILURE;
+    copia_cep(cep->cep_fim, token);
+
+    return EXIT_SUCCESS;
+}
+
+static inline int insere_cep(thash *h, const tcep * cep){ // Copia o registro lido para a arena (ou malloc) e insere
+    tcep *novo = (tcep *)(h->arena != NULL ? arena_aloca(h->arena, sizeof(tcep)) : malloc(sizeof(tcep)));
+    if (novo == NULL) {
+        fprintf(stderr, "Erro ao alocar o CEP %s\n", cep->cep_ini);
+        return EXIT_FAILURE;
+    }
+    memcpy(novo, cep, sizeof(tcep));
+
+    int resultado;
+
+    resultado = hash_insere(h, novo);
+
+    if (resultado == EXIT_FAILURE) {
+        printf("Erro ao inserir CEP %s\n", cep->cep_ini);
+        if (h->arena == NULL)
+            free(novo);
+    }
+    return resultado;
+}
+
+static inline int ler_CSV(FILE *file, thash *h) { // Funcao que permite a leitura dos dados do dataset
+    char line[256];
+    tcep cep;
+    fgets(line, sizeof(line), file);
+
+    while (fgets(line, sizeof(line), file)) {
+        if (le_linha_cep(line, &cep) == EXIT_SUCCESS && insere_cep(h, &cep) == EXIT_FAILURE)
+            return EXIT_FAILURE; // Tabela e arquivo fora de sincronia: o chamador decide o que fazer
+    }
+    return EXIT_SUCCESS;
+}
+
+static inline int carrega_dataset(thash * h){ // Le o ceps.csv numa tabela ja construida
+    FILE *file = fopen("ceps.csv", "r"); // Abre o arquivo
+    if (!file) {
+        fprintf(stderr, "Erro ao abrir o arquivo cep.csv\n");
+        return EXIT_FAILURE;
+    }
+    int resultado = ler_CSV(file, h); // Chama ler_CSV que ja adiciona os dados do dataset a tabela
+    fclose(file);
+
+    return resultado;
+}
+
+static inline int constroi_dataset_alocacao(thash * h, int nbuckets, char * (*get_key)(void *), float taxaocup, int politica){
+    if (hash_constroi_alocacao(h, nbuckets, get_key, taxaocup, politica) == EXIT_FAILURE) { // Constroi uma tabela com especificacoes dadas
+        fprintf(stderr, "Erro ao construir a tabela hash\n");
+        return EXIT_FAILURE;
+    }
+    if (carrega_dataset(h) == EXIT_FAILURE) {
+        hash_apaga(h); // Tabela pela metade nao volta ao chamador
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+static inline int constroi_dataset(thash * h, int nbuckets, char * (*get_key)(void *), float taxaocup){
+    return constroi_dataset_alocacao(h, nbuckets, get_key, taxaocup, ALOCA_CALLOC);
+}
+
+#endif
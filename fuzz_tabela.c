@@ -0,0 +1,257 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "cep.h"
+
+/* TESTE DIFERENCIAL E FUZZING DAS TABELAS
+   Cada entrada vira uma sequencia de insere/busca/remove aplicada as
+   configuracoes de hash_sl.c (linear) e hash_hd.c (dupla), a quadratica,
+   com e sem HT_GUARDA_HASH e cache, com a politica adaptativa de ocupacao (que cresce
+   e encolhe no meio da sequencia), e a um multiconjunto de referencia. Alem do
+   resultado, cada operacao tem de percorrer no maximo os slots nao vazios
+   da tabela (uma sondagem que repete slots ou nao para acusa erro) e no
+   maximo FATOR_SONDAGEM vezes a sondagem mais longa esperada para a taxa de
+   ocupacao e o tamanho da tabela, descontadas as copias da propria chave:
+   agrupamentos que crescem sem controle tambem acusam erro.
+
+     libFuzzer: clang -g -O1 -fsanitize=fuzzer,address -DFUZZ_LIBFUZZER fuzz_tabela.c
+     AFL:       afl-gcc -O2 -o fuzz_tabela fuzz_tabela.c && afl-fuzz -i in -o out ./fuzz_tabela @@
+     sozinho:   gcc -O2 -o fuzz_tabela fuzz_tabela.c && ./fuzz_tabela [entradas...]
+   Sem argumentos roda NITERACOES entradas aleatorias. */
+
+#define MAX_OPERACOES   4096
+#define NCHAVES         1000  // chaves distintas, poucas para forcar repeticoes e lapides
+#define NITERACOES      1000
+#define LIMITE_SEGUNDOS 10    // por entrada, no modo sozinho
+#define FATOR_SONDAGEM  3     // sondagem aceita ate 3x a mais longa esperada; nas entradas aleatorias o pior fica perto de 1x
+
+static int sondagem; // slots percorridos pela ultima operacao
+
+// Como assert, mas continua valendo com -DNDEBUG (comum nos builds de AFL)
+#define CONFERE(cond) do { if (!(cond)){ fprintf(stderr, "%s:%d: falhou %s\n", __FILE__, __LINE__, #cond); abort(); } } while (0)
+
+#define HT_CHAVE(h, reg)        (((tcep *)(reg))->cep_ini)
+#define HT_AO_SONDAR(h, n)      (sondagem = (n))
+#define HT_TAM_REGISTRO         sizeof(tcep)
+
+#define HT_PREFIXO              lin
+#define HT_TIPO                 tlin
+#define HT_SONDAGEM             HT_LINEAR
+#include "hash_tabela.h"
+
+#define HT_CHAVE(h, reg)        (((tcep *)(reg))->cep_ini)
+#define HT_AO_SONDAR(h, n)      (sondagem = (n))
+#define HT_PREFIXO              dup
+#define HT_TIPO                 tdup
+#define HT_SONDAGEM             HT_DUPLA
+#include "hash_tabela.h"
+
+#define HT_CHAVE(h, reg)        (((tcep *)(reg))->cep_ini)
+#define HT_AO_SONDAR(h, n)      (sondagem = (n))
+#define HT_PREFIXO              quad
+#define HT_TIPO                 tquad
+#define HT_SONDAGEM             HT_QUADRATICA
+#include "hash_tabela.h"
+
+#define HT_CHAVE(h, reg)        (((tcep *)(reg))->cep_ini)
+#define HT_AO_SONDAR(h, n)      (sondagem = (n))
+#define HT_PREFIXO              lin_guardado
+#define HT_TIPO                 tlin_guardado
+#define HT_SONDAGEM             HT_LINEAR
+#define HT_GUARDA_HASH
+#include "hash_tabela.h"
+
+#define HT_CHAVE(h, reg)        (((tcep *)(reg))->cep_ini)
+#define HT_AO_SONDAR(h, n)      (sondagem = (n))
+#define HT_PREFIXO              dup_guardado
+#define HT_TIPO                 tdup_guardado
+#define HT_SONDAGEM             HT_DUPLA
+#define HT_GUARDA_HASH
+#include "hash_tabela.h"
+
+#define HT_CHAVE(h, reg)        (((tcep *)(reg))->cep_ini)
+#define HT_AO_SONDAR(h, n)      (sondagem = (n))
+#define HT_PREFIXO              dup_adapta
+#define HT_TIPO                 tdup_adapta
+#define HT_SONDAGEM             HT_DUPLA
+#include "hash_tabela.h"
+
+/* FUNCOES AUXILIARES */
+
+static int ocupados(uintptr_t * table, int max, int escala){ // Slots com registro ou lapide
+    int n = 0;
+    for (int i = 0; i < max; i++)
+        n += table[escala * i] != 0;
+    return n;
+}
+
+static double ln(double x){ // Logaritmo natural por serie de atanh, para nao depender da libm
+    int k = 0;
+    for (; x > 2; x /= 2.718281828459045)
+        k++;
+    double y = (x - 1) / (x + 1), termo = y, soma = 0;
+    for (int i = 1; i < 60; i += 2, termo *= y * y)
+        soma += termo / i;
+    return k + 2 * soma;
+}
+
+static double maior_esperada(int tipo, float taxa, int max){
+    /* Sondagem mais longa esperada entre max slots com a ocupacao maxima que
+       a tabela admite, lapides incluidas ((1 + taxa) / 2, quando reconstroi):
+       ln(max) / (a - 1 - ln a) na linear (o maior agrupamento) e
+       ln(max) / ln(1/a) na dupla e na quadratica */
+    double a = (1 + taxa) / 2;
+    if (a > 0.99)
+        a = 0.99;
+    return ln(max + 1.0) / (tipo == HT_LINEAR ? a - 1 - ln(a) : -ln(a));
+}
+
+static void confere_sondagem(uintptr_t * table, int max, int escala, int tipo, float taxa, int copias,
+                             const char * tabela, int op){
+    int limite = ocupados(table, max, escala);
+    if (sondagem > limite || sondagem >= max){
+        fprintf(stderr, "%s: operacao %d percorreu %d slots com %d ocupados de %d\n", tabela, op, sondagem, limite, max);
+        abort();
+    }
+    // Copias da mesma chave tem o mesmo hash e se enfileiram na mesma sondagem
+    double esperada = maior_esperada(tipo, taxa, max);
+    if (sondagem - copias > FATOR_SONDAGEM * esperada){
+        fprintf(stderr, "%s: operacao %d percorreu %d slots (%d copias da chave), limite %.1f (%dx a mais longa esperada com %d slots)\n",
+                tabela, op, sondagem, copias, FATOR_SONDAGEM * esperada, FATOR_SONDAGEM, max);
+        abort();
+    }
+}
+
+/* Aplica a operacao a uma tabela e confere com a referencia */
+#define EXECUTA(prefixo, t, escala, tipo, op, chave, contagem) do {                                   \
+    sondagem = 0;                                                                               \
+    if (op == 0){                                                                               \
+        if (prefixo##_insere(&t, aloca_cep(chave, chave, "fuzz", "FZ")) != EXIT_SUCCESS){       \
+            fprintf(stderr, "%s: operacao %d nao inseriu %s\n", #prefixo, op, chave);           \
+            abort();                                                                            \
+        }                                                                                       \
+    }                                                                                           \
+    else if (op == 1){                                                                          \
+        tcep * r = (tcep *)prefixo##_busca(t, chave);                                           \
+        CONFERE((r != NULL) == (contagem > 0));                                                 \
+        CONFERE(r == NULL || strcmp(r->cep_ini, chave) == 0);                                   \
+    }                                                                                           \
+    else {                                                                                      \
+        int resultado = prefixo##_remove(&t, chave);                                            \
+        CONFERE((resultado == EXIT_SUCCESS) == (contagem > 0));                                 \
+    }                                                                                           \
+    confere_sondagem(t.table, t.max, escala, tipo, t.taxaocup, contagem, #prefixo, op);         \
+    CONFERE(t.size == total);                                                                   \
+} while (0)
+
+/* ENTRADA DO FUZZER */
+
+int LLVMFuzzerTestOneInput(const uint8_t * dados, size_t tamanho){
+    if (tamanho < 3)
+        return 0;
+    // Cabecalho: tamanho inicial, taxa de ocupacao e tamanho do cache (0 = sem cache)
+    int nbuckets = 1 + dados[0] % 64;
+    float taxa = 0.1 + (dados[1] % 90) / 100.0;
+    int ncache = (dados[2] & 1) ? 8 << (dados[2] % 4) : 0;
+    dados += 3;
+    tamanho -= 3;
+
+    tlin a;
+    tdup b;
+    tquad q;
+    tlin_guardado c;
+    tdup_guardado d;
+    tdup_adapta e;
+    // Chamadas fora de CONFERE/assert: com -DNDEBUG elas tem de continuar acontecendo
+    int montadas = lin_constroi(&a, nbuckets, get_key, taxa) == EXIT_SUCCESS;
+    montadas &= dup_constroi(&b, nbuckets, get_key, taxa) == EXIT_SUCCESS;
+    montadas &= quad_constroi(&q, nbuckets, get_key, taxa) == EXIT_SUCCESS;
+    montadas &= lin_guardado_constroi(&c, nbuckets, get_key, taxa) == EXIT_SUCCESS;
+    montadas &= dup_guardado_constroi(&d, nbuckets, get_key, taxa) == EXIT_SUCCESS;
+    montadas &= dup_adapta_constroi(&e, nbuckets, get_key, taxa) == EXIT_SUCCESS;
+    montadas &= dup_adapta_adapta_ativa(&e, 1.5, 8, 0) == EXIT_SUCCESS;
+    montadas &= lin_cache_ativa(&a, ncache) == EXIT_SUCCESS;
+    montadas &= dup_cache_ativa(&b, ncache) == EXIT_SUCCESS;
+    if (!montadas){
+        fprintf(stderr, "Erro ao montar as tabelas\n");
+        abort();
+    }
+
+    // Referencia: quantas copias de cada chave estao na tabela
+    static int contagem[NCHAVES];
+    memset(contagem, 0, sizeof(contagem));
+    int total = 0;
+
+    for (size_t i = 0; i + 2 < tamanho && i / 3 < MAX_OPERACOES; i += 3){
+        int op = dados[i] % 3;
+        int k = (dados[i + 1] << 8 | dados[i + 2]) % NCHAVES;
+        char chave[6];
+        snprintf(chave, sizeof(chave), "%05d", k * 97); // Espalha as chaves pelo espaco de CEPs
+        if (op == 0)
+            total++;
+        else if (op == 2 && contagem[k] > 0)
+            total--;
+        EXECUTA(lin, a, 1, HT_LINEAR, op, chave, contagem[k]);
+        EXECUTA(dup, b, 1, HT_DUPLA, op, chave, contagem[k]);
+        EXECUTA(quad, q, 1, HT_QUADRATICA, op, chave, contagem[k]);
+        EXECUTA(lin_guardado, c, 2, HT_LINEAR, op, chave, contagem[k]);
+        EXECUTA(dup_guardado, d, 2, HT_DUPLA, op, chave, contagem[k]);
+        EXECUTA(dup_adapta, e, 1, HT_DUPLA, op, chave, contagem[k]);
+        if (op == 0)
+            contagem[k]++;
+        else if (op == 2 && contagem[k] > 0)
+            contagem[k]--;
+    }
+
+    lin_apaga(&a);
+    dup_apaga(&b);
+    quad_apaga(&q);
+    lin_guardado_apaga(&c);
+    dup_guardado_apaga(&d);
+    dup_adapta_apaga(&e);
+    return 0;
+}
+
+/* MAIN (sem libFuzzer) */
+
+#ifndef FUZZ_LIBFUZZER
+static void executa_arquivo(const char * caminho){
+    FILE * f = fopen(caminho, "rb");
+    if (f == NULL){
+        fprintf(stderr, "Erro ao abrir %s\n", caminho);
+        exit(EXIT_FAILURE);
+    }
+    static uint8_t dados[3 * MAX_OPERACOES + 3];
+    size_t n = fread(dados, 1, sizeof(dados), f);
+    fclose(f);
+    alarm(LIMITE_SEGUNDOS); // Sondagem sem fim derruba o processo
+    LLVMFuzzerTestOneInput(dados, n);
+    alarm(0);
+}
+
+int main(int argc, char * argv[]){
+    if (argc > 1){
+        for (int i = 1; i < argc; i++)
+            executa_arquivo(argv[i]);
+        printf("%d entradas sem divergencia\n", argc - 1);
+        return EXIT_SUCCESS;
+    }
+    static uint8_t dados[3 * MAX_OPERACOES + 3];
+    srand(SEED);
+    for (int it = 0; it < NITERACOES; it++){
+        size_t n = 3 + rand() % (sizeof(dados) - 3);
+        for (size_t i = 0; i < n; i++)
+            dados[i] = rand();
+        if (it % 2) // Metade das entradas so insere e busca, para encher a tabela
+            for (size_t i = 3; i < n; i += 3)
+                dados[i] = dados[i] % 2;
+        alarm(LIMITE_SEGUNDOS);
+        LLVMFuzzerTestOneInput(dados, n);
+        alarm(0);
+    }
+    printf("%d entradas aleatorias sem divergencia\n", NITERACOES);
+    return EXIT_SUCCESS;
+}
+#endif
@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cep.h"
+
+/* Gera um header com o ceps.csv ja carregado numa tabela hash estatica
+   (ver tabela_estatica.h). Monta a tabela linear em tempo de execucao,
+   com o mesmo hash e sondagem da busca estatica, e escreve slots e
+   registros como vetores const.
+   Uso: gera_tabela [saida.h] (padrao ceps_tabela.h) */
+
+#define HT_CHAVE(h, reg)    (((tcep *)(reg))->cep_ini)
+#include "hash_tabela.h"
+#include "dataset.h"
+
+static void escreve_string(FILE * saida, const char * s){ // Literal C; bytes fora do ASCII em octal
+    fputc('"', saida);
+    for (const unsigned char * p = (const unsigned char *)s; *p; p++){
+        if (*p == '"' || *p == '\\')
+            fprintf(saida, "\\%c", *p);
+        else if (*p < 0x20 || *p >= 0x7f)
+            fprintf(saida, "\\%03o", *p);
+        else
+            fputc(*p, saida);
+    }
+    fputc('"', saida);
+}
+
+int main(int argc, char * argv[]){
+    const char * caminho = argc > 1 ? argv[1] : "ceps_tabela.h";
+    thash h;
+    if (constroi_dataset(&h, 6100, get_key, 0.7) == EXIT_FAILURE)
+        return EXIT_FAILURE;
+
+    FILE * saida = fopen(caminho, "w");
+    if (!saida){
+        fprintf(stderr, "Erro ao criar o arquivo %s\n", caminho);
+        return EXIT_FAILURE;
+    }
+    fprintf(saida, "/* Gerado por gera_tabela.c a partir do ceps.csv, nao editar */\n\n");
+    fprintf(saida, "#ifndef CEPS_TABELA_H\n#define CEPS_TABELA_H\n\n#include \"tabela_estatica.h\"\n\n");
+    fprintf(saida, "_Static_assert(CEP_DIGITOS == %d, \"gere de novo com o mesmo CEP_DIGITOS\");\n\n", CEP_DIGITOS);
+
+    // Registros na ordem dos slots, para a sondagem andar para frente na memoria
+    int32_t * indices = calloc(h.max, sizeof(int32_t));
+    fprintf(saida, "static const tcep ceps_registros[%d] = {\n", h.size);
+    int n = 0;
+    for (int i = 0; i < h.max; i++){
+        tcep * reg = (tcep *)hash_registro(h, i);
+        if (reg == NULL)
+            continue;
+        indices[i] = ++n;
+        fprintf(saida, "    {");
+        escreve_string(saida, reg->cep_ini);
+        fprintf(saida, ", ");
+        escreve_string(saida, reg->cep_fim);
+        fprintf(saida, ", ");
+        escreve_string(saida, reg->cidade);
+        fprintf(saida, ", ");
+        escreve_string(saida, reg->estado);
+        fprintf(saida, "},\n");
+    }
+    fprintf(saida, "};\n\n");
+
+    fprintf(saida, "static const int32_t ceps_slots[%d] = {", h.max);
+    for (int i = 0; i < h.max; i++)
+        fprintf(saida, "%s%d,", i % 16 ? " " : "\n    ", indices[i]);
+    fprintf(saida, "\n};\n\n");
+
+    fprintf(saida, "static const testatica ceps_estatica = {ceps_slots, ceps_registros, %d, %d};\n\n#endif\n", h.max, h.size);
+    fclose(saida);
+    printf("%s: %d registros em %d slots\n", caminho, h.size, h.max);
+
+    free(indices);
+    hash_apaga(&h);
+    return EXIT_SUCCESS;
+}
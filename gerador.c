@@ -0,0 +1,226 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* GERADOR DE DATASETS SINTETICOS DE CEP
+   Aprende do ceps.csv a distribuicao de linhas por UF, a concentracao dos
+   CEPs em prefixos de 3 digitos dentro de cada UF, a largura das faixas e
+   a taxa de cep_ini repetido, e gera um CSV no mesmo formato com qualquer
+   numero de linhas. Cada prefixo tem 10^(digitos-3) sufixos; com 8 digitos
+   cabem ~6*10^7 chaves distintas, para 10^8 linhas use 9 ou mais.
+   Uso: gerador <linhas> <saida.csv> [digitos] [semente] */
+
+#define MAX_UFS         32
+#define MAX_PREFIXOS    1000
+#define MAX_CIDADES     1024
+#define MAX_LARGURAS    8192
+
+/* ESTRUTURA DO MODELO */
+
+typedef struct {
+     char uf[3];
+     long linhas;
+     long prefixos[MAX_PREFIXOS]; // linhas por prefixo de 3 digitos
+     double acumulada[MAX_PREFIXOS];
+     char (*cidades)[50];
+     int ncidades;
+}tuf;
+
+typedef struct {
+     tuf ufs[MAX_UFS];
+     int nufs;
+     double acumulada[MAX_UFS];
+     long larguras[MAX_LARGURAS]; // cep_fim - cep_ini observados, em CEPs de 8 digitos
+     int nlarguras;
+     double taxa_repetidos;
+}tmodelo;
+
+/* FUNCOES AUXILIARES */
+
+static uint64_t estado_rng;
+
+static uint64_t aleatorio(){ // xorshift64*, reprodutivel pela semente
+    estado_rng ^= estado_rng >> 12;
+    estado_rng ^= estado_rng << 25;
+    estado_rng ^= estado_rng >> 27;
+    return estado_rng * 2685821657736338717ull;
+}
+
+static double uniforme(){
+    return (aleatorio() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static int sorteia(const double * acumulada, int n){ // Busca binaria na distribuicao acumulada
+    double u = uniforme();
+    int ini = 0, fim = n - 1;
+    while (ini < fim){
+        int meio = (ini + fim) / 2;
+        if (acumulada[meio] < u)
+            ini = meio + 1;
+        else
+            fim = meio;
+    }
+    return ini;
+}
+
+static tuf * acha_uf(tmodelo * m, const char * uf){
+    for (int i = 0; i < m->nufs; i++){
+        if (strcmp(m->ufs[i].uf, uf) == 0)
+            return &m->ufs[i];
+    }
+    if (m->nufs == MAX_UFS)
+        return NULL;
+    tuf * u = &m->ufs[m->nufs++];
+    strncpy(u->uf, uf, 2);
+    u->cidades = malloc(sizeof(*u->cidades) * MAX_CIDADES);
+    return u;
+}
+
+/* FUNCOES DO MODELO */
+
+static int aprende(tmodelo * m, const char * caminho){
+    FILE * file = fopen(caminho, "r");
+    if (!file){
+        fprintf(stderr, "Erro ao abrir o arquivo %s\n", caminho);
+        return EXIT_FAILURE;
+    }
+    memset(m, 0, sizeof(tmodelo));
+    char line[256];
+    long total = 0, repetidos = 0;
+    char (*vistos)[9] = NULL; // cep_ini ja lidos, para a taxa de repetidos
+    fgets(line, sizeof(line), file);
+    while (fgets(line, sizeof(line), file)){
+        char * resto;
+        char * uf = strtok_r(line, ",", &resto);
+        char * cidade = strtok_r(NULL, ",", &resto);
+        strtok_r(NULL, ",", &resto); // Faixa de CEP (ignora)
+        char * ini = strtok_r(NULL, ",", &resto);
+        char * fim = strtok_r(NULL, ",", &resto);
+        if (!uf || !cidade || !ini || !fim)
+            continue;
+        tuf * u = acha_uf(m, uf);
+        if (u == NULL)
+            continue;
+        long cep_ini = atol(ini), cep_fim = atol(fim); // O CSV perdeu os zeros a esquerda, atol recupera
+        u->linhas++;
+        u->prefixos[cep_ini / 100000]++;
+        if (u->ncidades < MAX_CIDADES){
+            strncpy(u->cidades[u->ncidades], cidade, 49);
+            u->cidades[u->ncidades++][49] = '\0';
+        }
+        if (m->nlarguras < MAX_LARGURAS)
+            m->larguras[m->nlarguras++] = cep_fim - cep_ini;
+        vistos = realloc(vistos, sizeof(*vistos) * (total + 1));
+        snprintf(vistos[total], sizeof(vistos[0]), "%08ld", cep_ini);
+        for (long i = 0; i < total; i++){
+            if (strcmp(vistos[i], vistos[total]) == 0){
+                repetidos++;
+                break;
+            }
+        }
+        total++;
+    }
+    fclose(file);
+    free(vistos);
+    if (total == 0)
+        return EXIT_FAILURE;
+    m->taxa_repetidos = (double)repetidos / total;
+
+    // Distribuicoes acumuladas
+    double soma = 0;
+    for (int i = 0; i < m->nufs; i++){
+        tuf * u = &m->ufs[i];
+        soma += (double)u->linhas / total;
+        m->acumulada[i] = soma;
+        double soma_p = 0;
+        for (int p = 0; p < MAX_PREFIXOS; p++){
+            soma_p += (double)u->prefixos[p] / u->linhas;
+            u->acumulada[p] = soma_p;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+/* GERACAO */
+
+static int gera(tmodelo * m, long linhas, const char * caminho, int digitos){
+    FILE * saida = fopen(caminho, "w");
+    if (!saida){
+        fprintf(stderr, "Erro ao criar o arquivo %s\n", caminho);
+        return EXIT_FAILURE;
+    }
+    long sufixos = 1;
+    for (int i = 3; i < digitos; i++)
+        sufixos *= 10;
+    long maximo = sufixos * MAX_PREFIXOS - 1;
+    // Sufixos usados por prefixo; 7919 e coprimo com 10^k, entao i * 7919 mod sufixos
+    // percorre todos os sufixos sem repetir e espalha as chaves do prefixo
+    long * usados = calloc(MAX_UFS * MAX_PREFIXOS, sizeof(long));
+
+    fprintf(saida, "Estado,Localidade,Faixa de CEP,CEP Inicial,CEP Final,Situação,Tipo de Faixa\n");
+    long ultimo = -1;
+    int ultimo_uf = 0, ultimo_repetido = 0;
+    for (long n = 0; n < linhas; n++){
+        long ini;
+        int iu;
+        if (ultimo >= 0 && !ultimo_repetido && uniforme() < m->taxa_repetidos){
+            // Repete o CEP anterior, como os distritos que dividem a faixa do municipio
+            ini = ultimo;
+            iu = ultimo_uf;
+            ultimo_repetido = 1;
+        }
+        else {
+            int p, tentativas = 0;
+            do { // Prefixo esgotado, sorteia outro
+                iu = sorteia(m->acumulada, m->nufs);
+                p = sorteia(m->ufs[iu].acumulada, MAX_PREFIXOS);
+            } while (usados[iu * MAX_PREFIXOS + p] >= sufixos && ++tentativas < 1000);
+            if (tentativas == 1000){
+                fprintf(stderr, "Chaves esgotadas na linha %ld, use mais digitos\n", n);
+                break;
+            }
+            ini = p * sufixos + (usados[iu * MAX_PREFIXOS + p]++ * 7919) % sufixos;
+            ultimo_repetido = 0;
+        }
+        tuf * u = &m->ufs[iu];
+        long fim = ini + m->larguras[aleatorio() % m->nlarguras] * (sufixos / 100000);
+        if (fim > maximo)
+            fim = maximo;
+        fprintf(saida, "%s,%s,%0*ld a %0*ld,%0*ld,%0*ld,Sintetico,Total do municipio\n", u->uf,
+                u->cidades[aleatorio() % u->ncidades], digitos, ini, digitos, fim, digitos, ini, digitos, fim);
+        ultimo = ini;
+        ultimo_uf = iu;
+    }
+    free(usados);
+    fclose(saida);
+    return EXIT_SUCCESS;
+}
+
+/* MAIN */
+
+int main(int argc, char * argv[]){
+    if (argc < 3){
+        fprintf(stderr, "Uso: %s <linhas> <saida.csv> [digitos] [semente]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    long linhas = atol(argv[1]);
+    int digitos = argc > 3 ? atoi(argv[3]) : 8;
+    estado_rng = argc > 4 ? strtoull(argv[4], NULL, 10) : 0x12345678;
+    if (estado_rng == 0)
+        estado_rng = 1;
+    if (digitos < 8 || digitos > 12){
+        fprintf(stderr, "digitos deve estar entre 8 e 12\n");
+        return EXIT_FAILURE;
+    }
+
+    tmodelo * m = malloc(sizeof(tmodelo));
+    if (m == NULL || aprende(m, "ceps.csv") == EXIT_FAILURE)
+        return EXIT_FAILURE;
+    fprintf(stderr, "Modelo: %d UFs, %.1f%% de cep_ini repetidos\n", m->nufs, 100 * m->taxa_repetidos);
+    int resultado = gera(m, linhas, argv[2], digitos);
+    for (int i = 0; i < m->nufs; i++)
+        free(m->ufs[i].cidades);
+    free(m);
+    return resultado;
+}
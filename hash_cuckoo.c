@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include "cep.h"
+
+#define HT_CHAVE(h, reg)    (((tcep *)(reg))->cep_ini) // Chave direta, sem chamar get_key
+#include "hash_cuckoo.h"
+#include "dataset.h"
+#include "testes.h"
+
+/* TESTES DE BUSCA */
+
+void teste_busca(){
+    int nbuckets = 6100;
+    float taxas[] = {0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 0.95, 0.99};
+    printf("Testando buscas com diferentes taxas de ocupação...\n");
+
+    for (int t = 0; t < (int)(sizeof(taxas) / sizeof(taxas[0])); t++){
+        thash h;
+        clock_t start = clock();
+        assert(constroi_dataset(&h, nbuckets, get_key, taxas[t]) == EXIT_SUCCESS);
+        assert(hash_busca(h, "69927") != NULL);
+        clock_t end = clock();
+        printf("Taxa %2.0f%%: %.4f segundos (ocupacao final %.1f%%)\n", taxas[t] * 100,
+               ((double) (end - start)) / CLOCKS_PER_SEC, 100.0 * h.size / h.max);
+        hash_apaga(&h);
+    }
+    printf("Todos os testes de busca passaram com sucesso!\n");
+}
+
+/* TESTES DE INSERÇÃO */
+
+void teste_insere6100buckets(){
+    int nbuckets = 6100;
+    thash h;
+    assert(constroi_dataset(&h, nbuckets, get_key, 0.7) == EXIT_SUCCESS);
+    hash_apaga(&h);
+}
+
+void teste_insere1000buckets(){
+    int nbuckets = 1000;
+    thash h;
+    assert(constroi_dataset(&h, nbuckets, get_key, 0.7) == EXIT_SUCCESS);
+    hash_apaga(&h);
+}
+
+/* TESTE DE REMOCAO */
+
+void teste_remove(){
+    thash h;
+    assert(constroi_dataset(&h, 6100, get_key, 0.95) == EXIT_SUCCESS);
+    int size = h.size;
+    assert(hash_remove(&h, "69927") == EXIT_SUCCESS);
+    assert(h.size == size - 1);
+    assert(hash_busca(h, "69927") == NULL);
+    assert(hash_remove(&h, "69927") == EXIT_FAILURE);
+    hash_apaga(&h);
+}
+
+void teste_reduzir(){ // Esvazia a tabela e encolhe ate onde os registros restantes cabem
+    thash h;
+    assert(constroi_dataset(&h, 6100, get_key, 0.9) == EXIT_SUCCESS);
+    char (*chaves)[6] = malloc(sizeof(*chaves) * h.size);
+    int n = 0;
+    for (int i = 0; i < h.max; i++){
+        if (hash_registro(h, i) != NULL)
+            strcpy(chaves[n++], get_key(hash_registro(h, i)));
+    }
+    int max = h.max;
+    for (int i = 0; i < n - 100; i++)
+        assert(hash_remove(&h, chaves[i]) == EXIT_SUCCESS);
+    while (hash_reduzir(&h) == EXIT_SUCCESS)
+        ;
+    assert(h.max < max && (float)(h.size + 1) / h.max < h.taxaocup);
+    for (int i = n - 100; i < n; i++)
+        assert(hash_busca(h, chaves[i]) != NULL);
+    printf("hash_reduzir com %d registros: %d -> %d posicoes\n", h.size, max, h.max);
+    free(chaves);
+    hash_apaga(&h);
+}
+
+/* MAIN */
+
+int main(int argc, char* argv[]){
+
+    clock_t start, end;
+    double cpu_time_used;
+
+    start = clock();
+    teste_insere1000buckets();
+    end = clock();
+    cpu_time_used = ((double) (end - start)) / CLOCKS_PER_SEC;
+    printf("Time for teste_insere1000buckets: %.4f seconds\n", cpu_time_used);
+
+    start = clock();
+    teste_insere6100buckets();
+    end = clock();
+    cpu_time_used = ((double) (end - start)) / CLOCKS_PER_SEC;
+    printf("Time for teste_insere6100buckets: %.4f seconds\n", cpu_time_used);
+
+    start = clock();
+    teste_busca();
+    end = clock();
+    cpu_time_used = ((double) (end - start)) / CLOCKS_PER_SEC;
+    printf("Time for teste_busca: %.4f seconds\n", cpu_time_used);
+
+    teste_remove();
+    teste_zeros_esquerda();
+    teste_reduzir();
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0){ // Comparativos demorados, com tabelas de ate 2^24 posicoes
+        teste_paginas_grandes();
+        teste_latencia();
+    }
+
+    return 0;
+}
@@ -0,0 +1,348 @@
+#ifndef HASH_CUCKOO_H
+#define HASH_CUCKOO_H
+
+/* TABELA HASH CUCKOO COM BALDES
+   Baldes de VIAS posicoes em uma linha de cache; toda busca le no maximo
+   dois baldes. Mesma interface da tabela de hash_tabela.h (thash, hash_*),
+   inclusive HT_CHAVE, HT_LIBERA e os ganchos HT_AO_* do indice secundario,
+   definidos antes do #include. */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hashf.h"
+#include "cep.h"
+
+#define VIAS    4   // posicoes por balde
+#define MAX_BFS 256 // baldes visitados na busca por caminho livre
+
+#ifndef HT_CHAVE
+#define HT_CHAVE(h, reg) ((h)->get_key(reg))
+#endif
+#ifndef HT_LIBERA
+#define HT_LIBERA(reg) free(reg)
+#endif
+#ifndef HT_AO_INSERIR
+#define HT_AO_INSERIR(h, reg) EXIT_SUCCESS
+#endif
+#ifndef HT_AO_REMOVER
+#define HT_AO_REMOVER(h, reg) ((void)0)
+#endif
+#ifndef HT_AO_APAGAR
+#define HT_AO_APAGAR(h) ((void)0)
+#endif
+
+/* ESTRUTURA DA TABELA */
+
+typedef struct {
+     _Alignas(64) uint32_t tags[VIAS]; // hash da chave de cada posicao, 0 = vazia
+     uintptr_t regs[VIAS];
+}tbalde; // 48 bytes alinhados em uma linha de cache de 64
+
+typedef struct {
+     tbalde * baldes;
+     int nbaldes;
+     int size;
+     int max; // nbaldes * VIAS
+     float taxaocup; // taxa de ocupacao da tabela
+     char * (*get_key)(void *);
+     int politica; // politica de alocacao pedida (ALOCA_*)
+     int alocacao; // como os baldes atuais foram obtidos
+     int no; // sempre -1, sem replicas NUMA
+     tarena * arena; // registros em blocos de paginas grandes, NULL = malloc por registro
+     void * indice; // indice secundario mantido pelos ganchos HT_AO_*, NULL = sem indice
+}thash;
+
+/* DECLARACOES DAS FUNCOES DA TABELA HASH*/
+
+static inline int hash_insere(thash * h, void * bucket);
+static inline int hash_duplicar(thash * h);
+static inline int hash_reduzir(thash * h);
+static inline int hash_constroi(thash * h, int nbuckets, char * (*get_key)(void *), float taxaocup);
+static inline int hash_constroi_alocacao(thash * h, int nbuckets, char * (*get_key)(void *), float taxaocup, int politica);
+static inline void *hash_busca(thash h, const char * key);
+static inline void hash_busca_lote(thash h, const char ** keys, int n, const uint64_t * ignorar, void ** saida);
+static inline int hash_remove(thash * h, const char * key);
+static inline void hash_apaga(thash *h);
+static inline void * hash_registro(thash h, int pos);
+
+/* FUNCOES TABELA HASH */
+
+static inline uint32_t tag_chave(const char * key){ // Hash completo guardado no balde, nunca 0
+    uint32_t tag = hashf(key, SEED);
+    return tag ? tag : 1;
+}
+
+static inline int balde_primario(thash * h, uint32_t tag){
+    return tag % h->nbaldes;
+}
+
+static inline int balde_alternativo(thash * h, int balde, uint32_t tag){
+    /* Cuckoo com chave parcial: o outro balde sai so do tag, entao
+       deslocamentos e duplicacoes nao precisam ler os registros.
+       f - b e simetrico e vale para qualquer numero de baldes */
+    int f = (int)(((tag * 0x5bd1e995u) >> 7) % h->nbaldes);
+    int alt = f - balde;
+    return alt < 0 ? alt + h->nbaldes : alt;
+}
+
+static inline tbalde * aloca_baldes(int nbaldes, int politica, int * alocacao){
+    if (politica != ALOCA_CALLOC) // mmap ja devolve paginas alinhadas
+        return (tbalde *)aloca_paginas(sizeof(tbalde) * nbaldes, politica, -1, alocacao);
+    *alocacao = ALOCA_CALLOC;
+    tbalde * b = aligned_alloc(64, sizeof(tbalde) * nbaldes);
+    if (b != NULL)
+        memset(b, 0, sizeof(tbalde) * nbaldes);
+    return b;
+}
+
+static inline int via_livre(tbalde * b){
+    for (int i = 0; i < VIAS; i++){
+        if (b->tags[i] == 0)
+            return i;
+    }
+    return -1;
+}
+
+typedef struct {
+    int balde;
+    int pai; // indice do no anterior na fila, -1 nos baldes da chave
+    int via_pai; // via do pai cujo registro vem para este balde
+} tpasso;
+
+static inline int no_caminho(tpasso * fila, int k, int balde){ // Evita repetir balde no mesmo caminho
+    for (; k >= 0; k = fila[k].pai){
+        if (fila[k].balde == balde)
+            return 1;
+    }
+    return 0;
+}
+
+static inline int insere_tag(thash * h, void * bucket, uint32_t tag){ // Insercao por BFS, EXIT_FAILURE se nao ha caminho
+    int b1 = balde_primario(h, tag);
+    int b2 = balde_alternativo(h, b1, tag);
+    int via;
+    int destino = b1;
+    if ((via = via_livre(&h->baldes[b1])) < 0){
+        destino = b2;
+        via = via_livre(&h->baldes[b2]);
+    }
+
+    if (via < 0){
+        tpasso fila[MAX_BFS];
+        int nfila = 0;
+        fila[nfila++] = (tpasso){b1, -1, -1};
+        fila[nfila++] = (tpasso){b2, -1, -1};
+        for (int k = 0; k < nfila && via < 0; k++){
+            tbalde * b = &h->baldes[fila[k].balde];
+            for (int i = 0; i < VIAS; i++){
+                int alt = balde_alternativo(h, fila[k].balde, b->tags[i]);
+                int livre = via_livre(&h->baldes[alt]);
+                if (livre >= 0){
+                    // Desloca os registros do fim do caminho ate o balde da chave
+                    int livre_balde = alt, livre_via = livre;
+                    int cur_balde = fila[k].balde, cur_via = i, no = k;
+                    while (1){
+                        tbalde * de = &h->baldes[cur_balde];
+                        tbalde * para = &h->baldes[livre_balde];
+                        para->tags[livre_via] = de->tags[cur_via];
+                        para->regs[livre_via] = de->regs[cur_via];
+                        livre_balde = cur_balde;
+                        livre_via = cur_via;
+                        if (fila[no].pai < 0)
+                            break;
+                        cur_via = fila[no].via_pai;
+                        no = fila[no].pai;
+                        cur_balde = fila[no].balde;
+                    }
+                    destino = livre_balde;
+                    via = livre_via;
+                    break;
+                }
+                if (nfila < MAX_BFS && !no_caminho(fila, k, alt))
+                    fila[nfila++] = (tpasso){alt, k, i};
+            }
+        }
+        if (via < 0)
+            return EXIT_FAILURE;
+    }
+
+    h->baldes[destino].tags[via] = tag;
+    h->baldes[destino].regs[via] = (uintptr_t)bucket;
+    h->size++;
+    return EXIT_SUCCESS;
+}
+
+static inline void desfaz_tag(thash * h, void * bucket, uint32_t tag){ // Tira o registro recem-inserido, sem libera-lo
+    int b = balde_primario(h, tag);
+    for (int k = 0; k < 2; k++){
+        for (int i = 0; i < VIAS; i++){
+            if (h->baldes[b].regs[i] == (uintptr_t)bucket){
+                h->baldes[b].tags[i] = 0;
+                h->baldes[b].regs[i] = 0;
+                h->size--;
+                return;
+            }
+        }
+        b = balde_alternativo(h, b, tag);
+    }
+}
+
+static inline int hash_insere(thash * h, void * bucket){
+    while ((float)(h->size + 1) / h->max >= h->taxaocup){
+        if (hash_duplicar(h) == EXIT_FAILURE)
+            return EXIT_FAILURE;
+    }
+
+    uint32_t tag = tag_chave(HT_CHAVE(h, bucket));
+    // Sem caminho livre a tabela dobra; chaves repetidas mais de 2*VIAS vezes nunca cabem
+    for (int tentativas = 0; tentativas < 4; tentativas++){
+        if (insere_tag(h, bucket, tag) == EXIT_SUCCESS){
+            if (HT_AO_INSERIR(h, bucket) == EXIT_FAILURE){
+                desfaz_tag(h, bucket, tag); // Indice e tabela continuam com os mesmos registros
+                return EXIT_FAILURE;
+            }
+            return EXIT_SUCCESS;
+        }
+        if (hash_duplicar(h) == EXIT_FAILURE)
+            break;
+    }
+    return EXIT_FAILURE;
+}
+
+static inline int redimensiona(thash * h, int nbaldes){
+    /* Reinsere os tags em nbaldes baldes, sem ler os registros. Se algum nao
+       couber, volta para os baldes anteriores e devolve EXIT_FAILURE */
+    thash anterior = *h;
+    h->nbaldes = nbaldes;
+    h->max = nbaldes * VIAS;
+    h->baldes = aloca_baldes(nbaldes, h->politica, &h->alocacao);
+    if (h->baldes == NULL){
+        *h = anterior;
+        return EXIT_FAILURE;
+    }
+    h->size = 0;
+    for (int b = 0; b < anterior.nbaldes; b++){
+        for (int i = 0; i < VIAS; i++){
+            if (anterior.baldes[b].tags[i] != 0 &&
+                insere_tag(h, (void *)anterior.baldes[b].regs[i], anterior.baldes[b].tags[i]) == EXIT_FAILURE){
+                libera_paginas(h->baldes, sizeof(tbalde) * nbaldes, h->alocacao);
+                *h = anterior;
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    libera_paginas(anterior.baldes, sizeof(tbalde) * anterior.nbaldes, anterior.alocacao);
+    return EXIT_SUCCESS;
+}
+
+static inline int hash_duplicar(thash * h){ // Duplica o numero de baldes reaproveitando os tags; na falha a tabela fica como estava
+    return redimensiona(h, h->nbaldes * 2);
+}
+
+static inline int hash_reduzir(thash * h){ // Metade dos baldes, se os registros couberem abaixo da taxa
+    int nbaldes = h->nbaldes / 2;
+    if (nbaldes < 1 || (float)(h->size + 1) / (nbaldes * VIAS) >= h->taxaocup)
+        return EXIT_FAILURE;
+    return redimensiona(h, nbaldes);
+}
+
+static inline int hash_constroi_alocacao(thash * h, int nbuckets, char * (*get_key)(void *), float taxaocup, int politica){
+    h->nbaldes = (nbuckets + VIAS) / VIAS; // Pelo menos nbuckets+1 posicoes
+    h->politica = politica;
+    h->no = -1;
+    h->baldes = aloca_baldes(h->nbaldes, politica, &h->alocacao);
+    if (h->baldes == NULL){
+        return EXIT_FAILURE;
+    }
+    h->arena = NULL;
+    if (politica != ALOCA_CALLOC){
+        h->arena = arena_cria(politica, h->no);
+        if (h->arena == NULL){
+            libera_paginas(h->baldes, sizeof(tbalde) * h->nbaldes, h->alocacao);
+            return EXIT_FAILURE;
+        }
+    }
+    h->max = h->nbaldes * VIAS;
+    h->size = 0;
+    h->get_key = get_key;
+    h->taxaocup = taxaocup;
+    h->indice = NULL;
+    return EXIT_SUCCESS;
+}
+
+static inline int hash_constroi(thash * h, int nbuckets, char * (*get_key)(void *), float taxaocup){
+    return hash_constroi_alocacao(h, nbuckets, get_key, taxaocup, ALOCA_CALLOC);
+}
+
+static inline void * hash_busca(thash h, const char * key){ // Le no maximo os dois baldes da chave
+    uint32_t tag = tag_chave(key);
+    int b = balde_primario(&h, tag);
+    for (int k = 0; k < 2; k++){
+        tbalde * balde = &h.baldes[b];
+        for (int i = 0; i < VIAS; i++){
+            if (balde->tags[i] == tag && strcmp(HT_CHAVE(&h, (void *)balde->regs[i]), key) == 0)
+                return (void *)balde->regs[i];
+        }
+        b = balde_alternativo(&h, b, tag);
+    }
+    return NULL;
+}
+
+static inline void hash_busca_lote(thash h, const char ** keys, int n, const uint64_t * ignorar, void ** saida){
+    // Mesma interface do busca_lote de hash_tabela.h; cada busca ja le so dois baldes
+    for (int i = 0; i < n; i++)
+        saida[i] = ignorar != NULL && (ignorar[i / 64] >> (i % 64) & 1) ? NULL : hash_busca(h, keys[i]);
+}
+
+static inline int hash_remove(thash * h, const char * key){
+    uint32_t tag = tag_chave(key);
+    int b = balde_primario(h, tag);
+    for (int k = 0; k < 2; k++){
+        tbalde * balde = &h->baldes[b];
+        for (int i = 0; i < VIAS; i++){
+            if (balde->tags[i] == tag && strcmp(HT_CHAVE(h, (void *)balde->regs[i]), key) == 0){
+                HT_AO_REMOVER(h, (void *)balde->regs[i]);
+                if (h->arena == NULL)
+                    HT_LIBERA((void *)balde->regs[i]);
+                balde->tags[i] = 0;
+                balde->regs[i] = 0;
+                h->size -= 1;
+                return EXIT_SUCCESS;
+            }
+        }
+        b = balde_alternativo(h, b, tag);
+    }
+    return EXIT_FAILURE;
+}
+
+static inline void hash_apaga(thash *h){
+    HT_AO_APAGAR(h); // O indice aponta para os registros, sai antes deles
+    h->indice = NULL;
+    for (int b = 0; b < h->nbaldes; b++){
+        for (int i = 0; i < VIAS; i++){
+            if (h->baldes[b].tags[i] != 0 && h->arena == NULL)
+                HT_LIBERA((void *)h->baldes[b].regs[i]);
+        }
+    }
+    libera_paginas(h->baldes, sizeof(tbalde) * h->nbaldes, h->alocacao);
+    if (h->arena != NULL){
+        arena_apaga(h->arena);
+        h->arena = NULL;
+    }
+}
+
+static inline void * hash_registro(thash h, int pos){ // Registro na posicao pos (balde pos / VIAS), NULL se vazia
+    tbalde * b = &h.baldes[pos / VIAS];
+    if (b->tags[pos % VIAS] == 0)
+        return NULL;
+    return (void *)b->regs[pos % VIAS];
+}
+
+#undef HT_LIBERA
+#undef HT_AO_INSERIR
+#undef HT_AO_REMOVER
+#undef HT_AO_APAGAR
+
+#endif
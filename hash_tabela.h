@@ -0,0 +1,782 @@
+/* TABELA HASH DE ENDERECAMENTO ABERTO
+   Cada inclusao gera uma tabela configurada pelas macros abaixo, definidas
+   antes do #include. Tudo e static inline, entao a chave e o hash entram
+   direto em busca/insere, sem chamada indireta.
+
+     HT_PREFIXO         prefixo das funcoes (padrao hash: hash_insere, hash_busca...)
+     HT_TIPO            nome do tipo da tabela (padrao thash)
+     HT_SONDAGEM        HT_LINEAR, HT_DUPLA ou HT_QUADRATICA (padrao HT_LINEAR)
+     HT_TIPO_CHAVE      tipo da chave (padrao const char *)
+     HT_CHAVE(h, reg)   chave de um registro (padrao (h)->get_key(reg), chamada indireta)
+     HT_HASH(key)       hash principal (padrao hashf(key, SEED))
+     HT_HASH2(key)      hash do passo na sondagem dupla (padrao hashf2(key))
+     HT_IGUAL(a, b)     comparacao de chaves (padrao strcmp)
+     HT_CHAVE_CACHE(key) chave inteira do cache, -1 se nao cacheavel (padrao chave_numerica)
+     HT_LIBERA(reg)     libera um registro removido (padrao free)
+     HT_TAM_REGISTRO    tamanho do registro, necessario para as replicas NUMA
+     HT_AO_INSERIR(h, reg), HT_AO_REMOVER(h, reg), HT_AO_APAGAR(h)
+                        ganchos para manter um indice secundario em h->indice;
+                        HT_AO_INSERIR devolve EXIT_FAILURE para desfazer o insere
+     HT_AO_SONDAR(h, n) recebe quantos slots cada insere/busca/remove percorreu
+     HT_GUARDA_HASH     guarda o hash de 64 bits ao lado de cada slot: duplicar
+                        nao le os registros e a busca descarta slots sem strcmp
+
+   Com hash_adapta_ativa a tabela escolhe a propria taxa de ocupacao:
+   mede a sondagem em amostras a cada janela de escritas e cresce, limpa
+   lapides, relaxa a taxa ou encolhe (hash_reduzir) para ficar dentro das
+   metas de sondagem media e de cauda e do orcamento de memoria.
+
+   As macros sao desfeitas no fim, entao o arquivo pode ser incluido de novo
+   com outro prefixo para ter varias tabelas no mesmo programa. */
+
+#ifndef HASH_TABELA_COMUM
+#define HASH_TABELA_COMUM
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <limits.h>
+#ifdef HASH_NUMA
+#include <sched.h>
+#endif
+#include "hashf.h"
+#include "alocacao.h"
+
+#define HASH_TABELA_GENERICA // tabelas com cache e replicas NUMA
+
+#define HT_LINEAR       1
+#define HT_DUPLA        2
+#define HT_QUADRATICA   3
+
+#define HT_JUNTA_(a, b) a##_##b
+#define HT_JUNTA(a, b)  HT_JUNTA_(a, b)
+
+/* ESTRUTURA DO CACHE DE CHAVES QUENTES */
+
+typedef struct {
+     _Atomic uint64_t * entradas; // (chave+1) << 32 | posicao na tabela, 0 = vazia
+     int max; // numero de entradas, potencia de 2
+     int bits;
+}tcache;
+
+/* FUNCOES DO CACHE DE CHAVES QUENTES */
+
+static inline int chave_numerica(const char * key){ // Chave do cache: digitos seguidos do comprimento, -1 se nao for CEP
+    int chave = 0;
+    int i;
+    for (i = 0; key[i]; i++){
+        if (i >= 8 || key[i] < '0' || key[i] > '9')
+            return -1;
+        chave = chave * 10 + (key[i] - '0');
+    }
+    if (i == 0)
+        return -1;
+    return chave * 10 + i; // O comprimento diferencia "01000" de "1000"
+}
+
+#define TAM_LOTE_BUSCA 16 // chaves com slot pre-carregado por rodada do busca_lote
+
+static inline int primo_seguinte(int n){ // Menor primo >= n
+    if (n <= 2)
+        return 2;
+    for (n |= 1; ; n += 2){
+        int d;
+        for (d = 3; d * d <= n && n % d != 0; d += 2)
+            ;
+        if (d * d > n)
+            return n;
+    }
+}
+
+static inline int potencia_seguinte(int n){ // Menor potencia de 2 >= n
+    int p = 1;
+    while (p < n)
+        p *= 2;
+    return p;
+}
+
+/* ESTRUTURA DA POLITICA ADAPTATIVA DE OCUPACAO */
+
+#define ADAPTA_AMOSTRAS 256   // buscas simuladas por medicao
+#define ADAPTA_JANELA   256   // escritas minimas entre medicoes (ou max/8)
+#define ADAPTA_TAXA_MIN 0.2f
+#define ADAPTA_TAXA_MAX 0.95f
+#define ADAPTA_PASSO    0.05f // quanto a taxa sobe quando a sondagem folga
+#define ADAPTA_FOLGA    0.75  // folga: medicao abaixo de 75% da meta
+
+typedef struct {
+     double meta_media; // slots lidos por busca com acerto, media; 0 = sem meta
+     int meta_cauda; // slots lidos pelo p99 das buscas com falha; 0 = sem meta
+     size_t orcamento; // bytes para os slots; 0 = sem limite
+     float teto; // menor carga que ja passou da meta, a taxa nao sobe alem dela
+     int escritas; // desde a ultima medicao
+     uint64_t sorteio; // estado do xorshift das amostras
+     double media; // ultima medicao
+     int cauda;
+     int crescimentos, limpezas, reducoes; // decisoes tomadas, para relatorio
+}tadapta;
+
+static inline uint64_t adapta_sorteia(tadapta * a){
+    a->sorteio ^= a->sorteio >> 12;
+    a->sorteio ^= a->sorteio << 25;
+    a->sorteio ^= a->sorteio >> 27;
+    return a->sorteio * 2685821657736338717ull;
+}
+
+static inline int compara_int(const void * a, const void * b){
+    return *(const int *)a - *(const int *)b;
+}
+
+static inline int cache_indice(tcache * c, int chave){
+    /* Hash multiplicativo de Knuth, usa os bits altos */
+    return (int)(((uint32_t)chave * 2654435761u) >> (32 - c->bits));
+}
+
+static inline void cache_apaga(tcache * c){
+    if (c != NULL){
+        free(c->entradas);
+        free(c);
+    }
+}
+
+#endif
+
+/* OPCOES DA TABELA */
+
+#ifndef HT_PREFIXO
+#define HT_PREFIXO hash
+#endif
+#ifndef HT_TIPO
+#define HT_TIPO thash
+#endif
+#ifndef HT_SONDAGEM
+#define HT_SONDAGEM HT_LINEAR
+#endif
+#ifndef HT_TIPO_CHAVE
+#define HT_TIPO_CHAVE const char *
+#endif
+#ifndef HT_CHAVE
+#define HT_CHAVE(h, reg) ((h)->get_key(reg))
+#endif
+#ifndef HT_HASH
+#define HT_HASH(key) hashf(key, SEED)
+#endif
+#ifndef HT_HASH2
+#define HT_HASH2(key) hashf2(key)
+#endif
+#ifndef HT_IGUAL
+#define HT_IGUAL(a, b) (strcmp((a), (b)) == 0)
+#endif
+#ifndef HT_CHAVE_CACHE
+#define HT_CHAVE_CACHE(key) chave_numerica(key)
+#endif
+#ifndef HT_LIBERA
+#define HT_LIBERA(reg) free(reg)
+#endif
+#ifndef HT_AO_INSERIR
+#define HT_AO_INSERIR(h, reg) EXIT_SUCCESS
+#endif
+#ifndef HT_AO_REMOVER
+#define HT_AO_REMOVER(h, reg) ((void)0)
+#endif
+#ifndef HT_AO_APAGAR
+#define HT_AO_APAGAR(h) ((void)0)
+#endif
+#ifndef HT_AO_SONDAR
+#define HT_AO_SONDAR(h, n) ((void)0)
+#endif
+
+#define HT_FN(nome) HT_JUNTA(HT_PREFIXO, nome)
+
+#ifdef HT_GUARDA_HASH
+#define HT_ESCALA 2 // cada slot ocupa dois uintptr_t: registro e hash
+_Static_assert(sizeof(uintptr_t) == sizeof(uint64_t), "HT_GUARDA_HASH precisa de ponteiros de 64 bits");
+#else
+#define HT_ESCALA 1
+#endif
+#define HT_SLOT(h, pos)      ((h)->table[HT_ESCALA * (pos)])
+#define HT_HASH_SLOT(h, pos) ((h)->table[HT_ESCALA * (pos) + 1]) // So com HT_GUARDA_HASH
+#define HT_TIPO_NUMA HT_JUNTA(HT_TIPO, numa)
+
+#if HT_SONDAGEM == HT_DUPLA
+#define HT_TAMANHO(n) primo_seguinte(n) // Com max primo todo passo percorre a tabela inteira
+#elif HT_SONDAGEM == HT_QUADRATICA
+#define HT_TAMANHO(n) potencia_seguinte(n) // Os numeros triangulares so cobrem todos os slots se max e potencia de 2
+#else
+#define HT_TAMANHO(n) (n)
+#endif
+
+#if HT_SONDAGEM == HT_QUADRATICA
+#define HT_AVANCA(pos, passo, max) do { pos = (pos + passo) % (max); passo++; } while (0) // Numeros triangulares
+#else
+#define HT_AVANCA(pos, passo, max) pos = (pos + passo) % (max)
+#endif
+
+/* ESTRUTURA DA TABELA */
+
+typedef struct {
+     uintptr_t * table;
+     int size;
+     int max;
+     uintptr_t deleted;
+     int lapides; // slots marcados com deleted
+     float taxaocup; // taxa de ocupacao da tabela
+     char * (*get_key)(void *);
+     tcache * cache; // cache na frente da tabela, NULL quando desativado
+     int politica; // politica de alocacao pedida (ALOCA_*)
+     int alocacao; // como a table atual foi obtida
+     int no; // no NUMA das alocacoes, -1 = qualquer
+     tarena * arena; // registros em blocos de paginas grandes, NULL = malloc por registro
+     void * indice; // indice secundario mantido pelos ganchos HT_AO_*, NULL = sem indice
+     tadapta * adapta; // politica adaptativa de ocupacao, NULL = taxaocup fixa
+}HT_TIPO;
+
+#ifdef HASH_NUMA
+typedef struct {
+     int nnos;
+     HT_TIPO * replicas; // uma copia somente leitura por no
+}HT_TIPO_NUMA;
+#endif
+
+/* DECLARACOES DAS FUNCOES DA TABELA HASH*/
+
+static inline int HT_FN(insere)(HT_TIPO * h, void * bucket);
+static inline int HT_FN(reinsere)(HT_TIPO * h, void * bucket);
+static inline int HT_FN(duplicar)(HT_TIPO * h);
+static inline int HT_FN(reconstroi)(HT_TIPO * h, int max);
+static inline int HT_FN(reduzir)(HT_TIPO * h);
+static inline void HT_FN(adapta_ajusta)(HT_TIPO * h, int remocao);
+static inline void HT_FN(cache_invalida)(HT_TIPO * h, HT_TIPO_CHAVE key);
+static inline void HT_FN(cache_limpa)(HT_TIPO * h);
+
+/* FUNCOES TABELA HASH */
+
+static inline uint64_t HT_FN(hash_chave)(HT_TIPO_CHAVE key){ // HT_HASH nos 32 bits baixos, HT_HASH2 nos altos
+#if defined(HT_GUARDA_HASH) || HT_SONDAGEM == HT_DUPLA
+    return (uint64_t)HT_HASH2(key) << 32 | (uint32_t)HT_HASH(key);
+#else
+    return (uint32_t)HT_HASH(key);
+#endif
+}
+
+static inline int HT_FN(passo)(uint64_t hash, int max){ // Passo inicial da sondagem
+#if HT_SONDAGEM == HT_DUPLA
+    return max > 1 ? 1 + (int)((uint32_t)(hash >> 32) % (uint32_t)(max - 1)) : 1;
+#else
+    (void)hash;
+    (void)max;
+    return 1;
+#endif
+}
+
+static inline int HT_FN(constroi_alocacao)(HT_TIPO * h, int nbuckets, char * (*get_key)(void *), float taxaocup, int politica){
+    h->politica = politica;
+    h->no = -1;
+    h->max = HT_TAMANHO(nbuckets+1);
+    h->table = (uintptr_t *)aloca_paginas(sizeof(void *) * HT_ESCALA * h->max, politica, h->no, &h->alocacao);
+    if (h->table == NULL){
+        return EXIT_FAILURE;
+    }
+    h->arena = NULL;
+    if (politica != ALOCA_CALLOC){ // Registros tambem em paginas grandes
+        h->arena = arena_cria(politica, h->no);
+        if (h->arena == NULL){
+            libera_paginas(h->table, sizeof(void *) * HT_ESCALA * h->max, h->alocacao);
+            return EXIT_FAILURE;
+        }
+    }
+    h->size = 0;
+    h->lapides = 0;
+    h->deleted = (uintptr_t)&(h->size);
+    h->get_key = get_key;
+    h->taxaocup = taxaocup;
+    h->cache = NULL;
+    h->indice = NULL;
+    h->adapta = NULL;
+    return EXIT_SUCCESS;
+}
+
+static inline int HT_FN(constroi)(HT_TIPO * h, int nbuckets, char * (*get_key)(void *), float taxaocup){
+    return HT_FN(constroi_alocacao)(h, nbuckets, get_key, taxaocup, ALOCA_CALLOC);
+}
+
+static inline int HT_FN(insere_hash)(HT_TIPO * h, void * bucket, uint64_t hash){ // Posiciona pelo hash, sem ler o registro
+    while ((float)(h->size + 1) / h->max >= h->taxaocup){
+        if (HT_FN(duplicar)(h) == EXIT_FAILURE)
+            return EXIT_FAILURE;
+    }
+    // Lapides tambem ocupam slots: passando do meio entre a taxa e a tabela cheia,
+    // refaz no mesmo tamanho para sempre sobrar slot vazio que encerre as sondagens
+    if ((float)(h->size + h->lapides + 1) / h->max >= (1 + h->taxaocup) / 2){
+        if (HT_FN(reconstroi)(h, h->max) == EXIT_FAILURE)
+            return EXIT_FAILURE;
+    }
+
+    int pos = (uint32_t)hash % h->max;
+    int passo = HT_FN(passo)(hash, h->max);
+
+    int tentativas = 0;
+    while (HT_SLOT(h, pos) && HT_SLOT(h, pos) != h->deleted && tentativas < h->max){
+        HT_AVANCA(pos, passo, h->max);
+        tentativas++;
+    }
+    HT_AO_SONDAR(h, tentativas);
+    // A sequencia de sondagem nao achou posicao livre, duplicamos
+    if (tentativas >= h->max){
+        if (HT_FN(duplicar)(h) == EXIT_FAILURE)
+            return EXIT_FAILURE;
+        return HT_FN(insere_hash)(h, bucket, hash);
+    }
+
+    if (HT_SLOT(h, pos) == h->deleted)
+        h->lapides--;
+    HT_SLOT(h, pos) = (uintptr_t)bucket;
+#ifdef HT_GUARDA_HASH
+    HT_HASH_SLOT(h, pos) = hash;
+#endif
+    h->size++;
+    return EXIT_SUCCESS;
+}
+
+static inline int HT_FN(reinsere)(HT_TIPO * h, void * bucket){ // Insercao sem os ganchos
+    HT_TIPO_CHAVE key = HT_CHAVE(h, bucket);
+    HT_FN(cache_invalida)(h, key); // Chave duplicada pode mudar o resultado da busca
+    return HT_FN(insere_hash)(h, bucket, HT_FN(hash_chave)(key));
+}
+
+static inline void HT_FN(desfaz)(HT_TIPO * h, void * bucket){ // Tira da tabela o registro recem-inserido, sem libera-lo
+    HT_TIPO_CHAVE key = HT_CHAVE(h, bucket);
+    uint64_t hash = HT_FN(hash_chave)(key);
+    int pos = (uint32_t)hash % h->max;
+    int passo = HT_FN(passo)(hash, h->max);
+    for (int tentativas = 0; HT_SLOT(h, pos) != 0 && tentativas < h->max; tentativas++){
+        if (HT_SLOT(h, pos) == (uintptr_t)bucket){
+            HT_FN(cache_invalida)(h, key);
+            HT_SLOT(h, pos) = h->deleted;
+            h->size--;
+            h->lapides++;
+            return;
+        }
+        HT_AVANCA(pos, passo, h->max);
+    }
+}
+
+static inline int HT_FN(insere)(HT_TIPO * h, void * bucket){
+    int resultado = HT_FN(reinsere)(h, bucket);
+    if (resultado == EXIT_SUCCESS && HT_AO_INSERIR(h, bucket) == EXIT_FAILURE){
+        HT_FN(desfaz)(h, bucket); // Indice e tabela continuam com os mesmos registros
+        return EXIT_FAILURE;
+    }
+    if (resultado == EXIT_SUCCESS)
+        HT_FN(adapta_ajusta)(h, 0);
+    return resultado;
+}
+
+static inline int HT_FN(duplicar)(HT_TIPO * h){ // Duplica o tamanho da tabela; sem memoria, fica como estava
+    return HT_FN(reconstroi)(h, HT_TAMANHO(h->max * 2));
+}
+
+static inline int HT_FN(reduzir)(HT_TIPO * h){ // Metade do tamanho, se os registros couberem abaixo da taxa
+    int max = HT_TAMANHO(h->max / 2);
+    if (max < 2 || max >= h->max || (float)(h->size + 1) / max >= h->taxaocup)
+        return EXIT_FAILURE;
+    return HT_FN(reconstroi)(h, max);
+}
+
+static inline int HT_FN(reconstroi)(HT_TIPO * h, int max){ // Reinsere tudo numa tabela com max slots, sem lapides
+    // Em caso de falha a tabela antiga continua intacta e volta para h
+    HT_TIPO anterior = *h;
+    h->max = max;
+    h->table = (uintptr_t *)aloca_paginas(sizeof(void *) * HT_ESCALA * h->max, h->politica, h->no, &h->alocacao);
+    if (h->table == NULL){
+        fprintf(stderr, "Erro ao redimensionar a tabela hash\n");
+        *h = anterior;
+        return EXIT_FAILURE;
+    }
+    h->size = 0;
+    h->lapides = 0;
+    for (int i = 0; i < anterior.max; i++){ // Insere os valores da antiga tabela
+        uintptr_t reg = HT_SLOT(&anterior, i);
+        if (reg != 0 && reg != h->deleted){
+#ifdef HT_GUARDA_HASH
+            int resultado = HT_FN(insere_hash)(h, (void *)reg, HT_HASH_SLOT(&anterior, i)); // Sem ler o registro
+#else
+            int resultado = HT_FN(insere_hash)(h, (void *)reg, HT_FN(hash_chave)(HT_CHAVE(h, (void *)reg)));
+#endif
+            if (resultado == EXIT_FAILURE){
+                libera_paginas(h->table, sizeof(void *) * HT_ESCALA * h->max, h->alocacao);
+                *h = anterior;
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    libera_paginas(anterior.table, sizeof(void *) * HT_ESCALA * anterior.max, anterior.alocacao);
+    HT_FN(cache_limpa)(h); // Posicoes mudaram, descarta o cache
+    return EXIT_SUCCESS;
+}
+
+static inline void * HT_FN(cache_busca)(HT_TIPO h, int chave){
+    /* Cada entrada e um unico uint64_t atomico, entao leitores concorrentes
+       nunca enxergam chave e posicao de escritas diferentes */
+    if (h.cache == NULL || chave < 0)
+        return NULL;
+    uint64_t e = atomic_load_explicit(&h.cache->entradas[cache_indice(h.cache, chave)], memory_order_relaxed);
+    if ((e >> 32) != (uint64_t)chave + 1)
+        return NULL;
+    return (void *)HT_SLOT(&h, (uint32_t)e);
+}
+
+static inline void HT_FN(cache_guarda)(HT_TIPO h, int chave, int pos){
+    if (h.cache == NULL || chave < 0)
+        return;
+    uint64_t e = ((uint64_t)chave + 1) << 32 | (uint32_t)pos;
+    atomic_store_explicit(&h.cache->entradas[cache_indice(h.cache, chave)], e, memory_order_relaxed);
+}
+
+static inline void * HT_FN(busca_hash)(HT_TIPO h, HT_TIPO_CHAVE key, uint64_t hash, int chave){ // Sondagem com o hash ja calculado
+    int pos = (uint32_t)hash % h.max;
+    int passo = HT_FN(passo)(hash, h.max);
+    int tentativas = 0;
+    while(HT_SLOT(&h, pos) != 0 && tentativas < h.max){
+        if (HT_SLOT(&h, pos) != h.deleted
+#ifdef HT_GUARDA_HASH
+            && HT_HASH_SLOT(&h, pos) == hash // Descarta sem ler o registro
+#endif
+            && HT_IGUAL(HT_CHAVE(&h, (void *)HT_SLOT(&h, pos)), key)){
+            HT_AO_SONDAR(&h, tentativas);
+            HT_FN(cache_guarda)(h, chave, pos);
+            return (void *)HT_SLOT(&h, pos);
+        }
+        HT_AVANCA(pos, passo, h.max);
+        tentativas++;
+    }
+    HT_AO_SONDAR(&h, tentativas);
+    return NULL;
+}
+
+static inline void * HT_FN(busca)(HT_TIPO h, HT_TIPO_CHAVE key){
+    int chave = h.cache != NULL ? HT_CHAVE_CACHE(key) : -1;
+    void * reg = HT_FN(cache_busca)(h, chave); // Consulta o cache antes da sondagem
+    if (reg != NULL)
+        return reg;
+    return HT_FN(busca_hash)(h, key, HT_FN(hash_chave)(key), chave);
+}
+
+static inline void HT_FN(busca_lote)(HT_TIPO h, HT_TIPO_CHAVE * keys, int n, const uint64_t * ignorar, void ** saida){
+    /* Busca n chaves de uma vez: calcula os hashes de TAM_LOTE_BUSCA chaves
+       e pede o primeiro slot de cada uma antes de sondar, para que as faltas
+       de cache se sobreponham. Chaves com o bit ligado em ignorar (entrada
+       malformada, NULL = nenhuma) dao NULL. Nao passa pelo cache de chaves quentes */
+    uint64_t hashes[TAM_LOTE_BUSCA];
+    for (int ini = 0; ini < n; ini += TAM_LOTE_BUSCA){
+        int fim = ini + TAM_LOTE_BUSCA < n ? ini + TAM_LOTE_BUSCA : n;
+        for (int i = ini; i < fim; i++){
+            if (ignorar != NULL && (ignorar[i / 64] >> (i % 64) & 1))
+                continue;
+            hashes[i - ini] = HT_FN(hash_chave)(keys[i]);
+            __builtin_prefetch(&HT_SLOT(&h, (uint32_t)hashes[i - ini] % h.max));
+        }
+        for (int i = ini; i < fim; i++){
+            if (ignorar != NULL && (ignorar[i / 64] >> (i % 64) & 1))
+                saida[i] = NULL;
+            else
+                saida[i] = HT_FN(busca_hash)(h, keys[i], hashes[i - ini], -1);
+        }
+    }
+}
+
+static inline int HT_FN(remove)(HT_TIPO * h, HT_TIPO_CHAVE key){
+    uint64_t hash = HT_FN(hash_chave)(key);
+    int pos = (uint32_t)hash % h->max;
+    int passo = HT_FN(passo)(hash, h->max);
+    int tentativas = 0;
+    while(HT_SLOT(h, pos)!=0 && tentativas < h->max){
+        if (HT_SLOT(h, pos) != h->deleted
+#ifdef HT_GUARDA_HASH
+            && HT_HASH_SLOT(h, pos) == hash
+#endif
+            && HT_IGUAL(HT_CHAVE(h, (void *)HT_SLOT(h, pos)), key)){
+            HT_FN(cache_invalida)(h, key);
+            HT_AO_REMOVER(h, (void *)HT_SLOT(h, pos));
+            if (h->arena == NULL) // Na arena o registro so e liberado em apaga
+                HT_LIBERA((void *)HT_SLOT(h, pos));
+            HT_SLOT(h, pos) = h->deleted;
+            h->size -=1;
+            h->lapides++;
+            HT_AO_SONDAR(h, tentativas);
+            HT_FN(adapta_ajusta)(h, 1);
+            return EXIT_SUCCESS;
+        }
+        HT_AVANCA(pos, passo, h->max);
+        tentativas++;
+    }
+    HT_AO_SONDAR(h, tentativas);
+    return EXIT_FAILURE;
+}
+
+static inline void HT_FN(apaga)(HT_TIPO * h){
+    HT_AO_APAGAR(h); // O indice aponta para os registros, sai antes deles
+    h->indice = NULL;
+    int pos;
+    for(pos =0;pos< h->max;pos++){
+        if (HT_SLOT(h, pos) != 0){
+            if (HT_SLOT(h, pos)!=h->deleted && h->arena == NULL){
+                HT_LIBERA((void *)HT_SLOT(h, pos));
+            }
+        }
+    }
+    libera_paginas(h->table, sizeof(void *) * HT_ESCALA * h->max, h->alocacao);
+    if (h->arena != NULL){
+        arena_apaga(h->arena);
+        h->arena = NULL;
+    }
+    cache_apaga(h->cache);
+    h->cache = NULL;
+    free(h->adapta);
+    h->adapta = NULL;
+}
+
+static inline void * HT_FN(registro)(HT_TIPO h, int pos){ // Registro na posicao pos, NULL se vazia
+    if (HT_SLOT(&h, pos) == 0 || HT_SLOT(&h, pos) == h.deleted)
+        return NULL;
+    return (void *)HT_SLOT(&h, pos);
+}
+
+/* FUNCOES DO CACHE */
+
+static inline int HT_FN(cache_ativa)(HT_TIPO * h, int nentradas){ // Cache mapeado diretamente com nentradas (arredonda para potencia de 2), 0 desativa
+    cache_apaga(h->cache);
+    h->cache = NULL;
+    if (nentradas <= 0){
+        return EXIT_SUCCESS;
+    }
+    tcache * c = (tcache *)malloc(sizeof(tcache));
+    if (c == NULL){
+        return EXIT_FAILURE;
+    }
+    c->bits = 1;
+    while ((1 << c->bits) < nentradas)
+        c->bits++;
+    c->max = 1 << c->bits;
+    c->entradas = calloc(c->max, sizeof *c->entradas);
+    if (c->entradas == NULL){
+        free(c);
+        return EXIT_FAILURE;
+    }
+    h->cache = c;
+    return EXIT_SUCCESS;
+}
+
+static inline void HT_FN(cache_invalida)(HT_TIPO * h, HT_TIPO_CHAVE key){ // Remove a chave do cache, se estiver nele
+    if (h->cache == NULL)
+        return;
+    int chave = HT_CHAVE_CACHE(key);
+    if (chave < 0)
+        return;
+    _Atomic uint64_t * e = &h->cache->entradas[cache_indice(h->cache, chave)];
+    if ((atomic_load_explicit(e, memory_order_relaxed) >> 32) == (uint64_t)chave + 1)
+        atomic_store_explicit(e, 0, memory_order_relaxed);
+}
+
+static inline void HT_FN(cache_limpa)(HT_TIPO * h){
+    if (h->cache == NULL)
+        return;
+    for (int i = 0; i < h->cache->max; i++)
+        atomic_store_explicit(&h->cache->entradas[i], 0, memory_order_relaxed);
+}
+
+/* POLITICA ADAPTATIVA DE OCUPACAO */
+
+static inline int HT_FN(adapta_ativa)(HT_TIPO * h, double meta_media, int meta_cauda, size_t orcamento){
+    /* Metas em slots lidos por busca (o slot de origem conta 1) e orcamento em
+       bytes para os slots; tudo zero desativa e a taxaocup atual fica fixa */
+    free(h->adapta);
+    h->adapta = NULL;
+    if (meta_media <= 0 && meta_cauda <= 0 && orcamento == 0)
+        return EXIT_SUCCESS;
+    tadapta * a = (tadapta *)calloc(1, sizeof(tadapta));
+    if (a == NULL)
+        return EXIT_FAILURE;
+    a->meta_media = meta_media;
+    a->meta_cauda = meta_cauda;
+    a->orcamento = orcamento;
+    a->teto = ADAPTA_TAXA_MAX;
+    a->sorteio = SEED | 1;
+    h->adapta = a;
+    return EXIT_SUCCESS;
+}
+
+static inline int HT_FN(adapta_acerto)(HT_TIPO * h, int alvo){ // Slots que a busca do registro em alvo le ate acha-lo
+#ifdef HT_GUARDA_HASH
+    uint64_t hash = HT_HASH_SLOT(h, alvo);
+#else
+    uint64_t hash = HT_FN(hash_chave)(HT_CHAVE(h, (void *)HT_SLOT(h, alvo)));
+#endif
+    int pos = (uint32_t)hash % h->max;
+    int passo = HT_FN(passo)(hash, h->max);
+    int lidos = 1;
+    while (pos != alvo && lidos < h->max){
+        HT_AVANCA(pos, passo, h->max);
+        lidos++;
+    }
+    return lidos;
+}
+
+static inline void HT_FN(adapta_mede)(HT_TIPO * h){
+    /* Media das buscas com acerto de registros sorteados e p99 das buscas
+       com falha a partir de posicoes sorteadas, que tambem atravessam lapides */
+    tadapta * a = h->adapta;
+    int falhas[ADAPTA_AMOSTRAS];
+    long soma = 0;
+    int acertos = 0;
+    for (int k = 0; k < ADAPTA_AMOSTRAS; k++){
+        uint64_t r = adapta_sorteia(a);
+        int pos = (uint32_t)r % h->max;
+        int passo = HT_FN(passo)(r, h->max);
+        int lidos = 1;
+        while (HT_SLOT(h, pos) != 0 && lidos < h->max){
+            HT_AVANCA(pos, passo, h->max);
+            lidos++;
+        }
+        falhas[k] = lidos;
+        for (int t = 0; t < 4 && h->size > 0; t++){ // Ate 4 slots sorteados por registro amostrado
+            int alvo = (uint32_t)adapta_sorteia(a) % h->max;
+            if (HT_SLOT(h, alvo) != 0 && HT_SLOT(h, alvo) != h->deleted){
+                soma += HT_FN(adapta_acerto)(h, alvo);
+                acertos++;
+                break;
+            }
+        }
+    }
+    qsort(falhas, ADAPTA_AMOSTRAS, sizeof(int), compara_int);
+    a->media = acertos > 0 ? (double)soma / acertos : 1;
+    a->cauda = falhas[ADAPTA_AMOSTRAS * 99 / 100];
+}
+
+static inline void HT_FN(adapta_ajusta)(HT_TIPO * h, int remocao){ // Chamada a cada escrita; mede e decide uma vez por janela
+    tadapta * a = h->adapta;
+    if (a == NULL)
+        return;
+    // Tabela esvaziada pelas remocoes: encolhe na hora, enquanto couber
+    while (remocao && h->size < h->max * h->taxaocup / 4 && HT_FN(reduzir)(h) == EXIT_SUCCESS){
+        a->teto = ADAPTA_TAXA_MAX; // A carga de antes nao vale para o novo tamanho
+        a->reducoes++;
+    }
+    if (++a->escritas < (h->max / 8 > ADAPTA_JANELA ? h->max / 8 : ADAPTA_JANELA))
+        return;
+    a->escritas = 0;
+    HT_FN(adapta_mede)(h);
+    long limite = a->orcamento > 0 ? (long)(a->orcamento / (sizeof(uintptr_t) * HT_ESCALA)) : LONG_MAX;
+    int acima = (a->meta_media > 0 && a->media > a->meta_media) || (a->meta_cauda > 0 && a->cauda > a->meta_cauda);
+    int folga = (a->meta_media <= 0 || a->media < ADAPTA_FOLGA * a->meta_media) &&
+                (a->meta_cauda <= 0 || a->cauda < ADAPTA_FOLGA * a->meta_cauda);
+    float carga = (float)h->size / h->max;
+
+    if (acima && h->lapides > h->size / 4){ // Boa parte da sondagem e lapide: limpa sem crescer
+        if (HT_FN(reconstroi)(h, h->max) == EXIT_SUCCESS)
+            a->limpezas++;
+    }
+    else if (acima && HT_TAMANHO(h->max * 2) <= limite){ // Esta carga ja passa da meta
+        a->teto = carga > ADAPTA_TAXA_MIN ? carga : ADAPTA_TAXA_MIN;
+        h->taxaocup = a->teto;
+        if (HT_FN(duplicar)(h) == EXIT_SUCCESS) // Sem memoria, a proxima insercao tenta de novo
+            a->crescimentos++;
+    }
+    else if (folga && h->taxaocup < a->teto)
+        h->taxaocup = h->taxaocup + ADAPTA_PASSO < a->teto ? h->taxaocup + ADAPTA_PASSO : a->teto;
+
+    if (HT_TAMANHO(h->max * 2) > limite) // Sem orcamento para dobrar: so cresce perto de cheia
+        h->taxaocup = ADAPTA_TAXA_MAX;
+    while (h->max > limite && HT_FN(reduzir)(h) == EXIT_SUCCESS) // Acima do orcamento
+        a->reducoes++;
+}
+
+/* REPLICAS POR NO NUMA */
+
+#if defined(HASH_NUMA) && defined(HT_TAM_REGISTRO)
+static inline void HT_FN(replica_apaga)(HT_TIPO_NUMA * r){
+    for (int no = 0; no < r->nnos; no++)
+        HT_FN(apaga)(&r->replicas[no]);
+    free(r->replicas);
+    r->replicas = NULL;
+    r->nnos = 0;
+}
+
+static inline int HT_FN(replica_numa)(HT_TIPO * h, HT_TIPO_NUMA * r){ // Copia somente leitura de slots e registros em cada no
+    if (numa_available() < 0)
+        return EXIT_FAILURE;
+    r->nnos = numa_max_node() + 1;
+    r->replicas = (HT_TIPO *)calloc(r->nnos, sizeof(HT_TIPO));
+    if (r->replicas == NULL)
+        return EXIT_FAILURE;
+    for (int no = 0; no < r->nnos; no++){
+        HT_TIPO * c = &r->replicas[no];
+        *c = *h;
+        c->cache = NULL;
+        c->adapta = NULL; // Replica somente leitura nao redimensiona
+        c->indice = NULL; // Replica somente leitura, sem indice proprio
+        c->no = no;
+        c->deleted = (uintptr_t)&(c->size);
+        c->table = (uintptr_t *)aloca_paginas(sizeof(uintptr_t) * HT_ESCALA * c->max, h->politica, no, &c->alocacao);
+        c->arena = arena_cria(h->politica, no);
+        if (c->table == NULL || c->arena == NULL){
+            libera_paginas(c->table, sizeof(uintptr_t) * HT_ESCALA * c->max, c->alocacao);
+            if (c->arena != NULL)
+                arena_apaga(c->arena);
+            r->nnos = no;
+            HT_FN(replica_apaga)(r);
+            return EXIT_FAILURE;
+        }
+        for (int i = 0; i < h->max; i++){
+            if (HT_SLOT(h, i) == 0)
+                continue;
+            if (HT_SLOT(h, i) == h->deleted){
+                HT_SLOT(c, i) = c->deleted;
+                continue;
+            }
+            void * reg = arena_aloca(c->arena, HT_TAM_REGISTRO);
+            memcpy(reg, (void *)HT_SLOT(h, i), HT_TAM_REGISTRO);
+            HT_SLOT(c, i) = (uintptr_t)reg;
+#ifdef HT_GUARDA_HASH
+            HT_HASH_SLOT(c, i) = HT_HASH_SLOT(h, i);
+#endif
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+static inline HT_TIPO * HT_FN(replica_local)(HT_TIPO_NUMA * r){ // Replica do no da thread atual, consultar uma vez por thread
+    int no = numa_node_of_cpu(sched_getcpu());
+    if (no < 0 || no >= r->nnos)
+        no = 0;
+    return &r->replicas[no];
+}
+#endif
+
+/* Desfaz as opcoes para permitir outra inclusao */
+
+#undef HT_PREFIXO
+#undef HT_TIPO
+#undef HT_SONDAGEM
+#undef HT_TIPO_CHAVE
+#undef HT_CHAVE
+#undef HT_HASH
+#undef HT_HASH2
+#undef HT_IGUAL
+#undef HT_CHAVE_CACHE
+#undef HT_LIBERA
+#undef HT_TAM_REGISTRO
+#undef HT_AO_INSERIR
+#undef HT_AO_REMOVER
+#undef HT_AO_APAGAR
+#undef HT_AO_SONDAR
+#undef HT_GUARDA_HASH
+#undef HT_ESCALA
+#undef HT_SLOT
+#undef HT_HASH_SLOT
+#undef HT_FN
+#undef HT_TIPO_NUMA
+#undef HT_AVANCA
+#undef HT_TAMANHO
@@ -0,0 +1,35 @@
+#ifndef HASHF_H
+#define HASHF_H
+
+#include <stdint.h>
+
+#ifndef SEED
+#define SEED    0x12345678
+#endif
+
+/* FUNCOES HASH DE STRINGS */
+
+static inline uint32_t hashf(const char* str, uint32_t h){
+    /* One-byte-at-a-time Murmur hash
+    Source: https://github.com/aappleby/smhasher/blob/master/src/Hashes.cpp */
+    for (; *str; ++str) {
+        h ^= *str;
+        h *= 0x5bd1e995;
+        h ^= h >> 15;
+    }
+    return h;
+}
+
+static inline uint32_t hashf2(const char* str) { // Segunda funcao hash, usada no passo da sondagem dupla
+    /* Bernstein hash
+    Source: https://github.com/aappleby/smhasher/blob/master/src/Hashes.cpp */
+    uint32_t seed = 5381;
+
+    for (; *str; ++str){
+        seed = 33 * seed + (unsigned char)*str;
+    }
+
+    return seed;
+}
+
+#endif
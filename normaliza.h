@@ -0,0 +1,179 @@
+#ifndef NORMALIZA_H
+#define NORMALIZA_H
+
+/* NORMALIZACAO DE CONSULTAS DE CEP EM LOTE
+   Entrada: texto com uma consulta por linha, "69945-000" ou "69945000",
+   com espacos, tabs ou \r em volta. Saida: o CEP como inteiro de 8 digitos
+   e um bitmap com as linhas malformadas, prontos para o busca_lote.
+   Com SSE2 cada linha e classificada 16 bytes por vez (digitos, hifen,
+   espacos, fim de linha) e os 8 digitos viram inteiro por SWAR, sem laco
+   por caractere. Linhas com 16 bytes ou mais, o fim do texto e maquinas sem
+   SSE2 usam normaliza_cep, a versao escalar, que tambem e a referencia.
+
+   hash_cep, cep_numero e CEP_IGUAL instanciam a tabela com chave uint32_t
+   (o CEP de 8 digitos, comparado pelos primeiros CEP_DIGITOS), entao a
+   saida vai para o busca_lote como esta, sem voltar a ser texto. */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "hashf.h"
+#include "cep.h"
+
+_Static_assert(CEP_DIGITOS <= 8, "a chave sai dos 8 digitos do CEP");
+
+/* FUNCOES AUXILIARES */
+
+static inline int eh_espaco(char c){
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline uint32_t digitos_swar(uint64_t x){ // 8 digitos ASCII, o primeiro no byte baixo, para inteiro
+    x -= 0x3030303030303030ull;
+    x = x * 10 + (x >> 8); // Pares de digitos nos bytes pares
+    x = ((x & 0x000000FF000000FFull) * (100 + (1000000ull << 32)) +
+         ((x >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32))) >> 32;
+    return (uint32_t)x;
+}
+
+static inline void cep_chave(uint32_t cep, char * chave){ // Primeiros CEP_DIGITOS digitos, com os zeros a esquerda
+    for (int i = 7; i >= 0; i--){
+        if (i < CEP_DIGITOS)
+            chave[i] = '0' + cep % 10;
+        cep /= 10;
+    }
+    chave[CEP_DIGITOS] = '\0';
+}
+
+/* CHAVE INTEIRA */
+
+static inline uint32_t divisor_cep(){ // 10^(8 - CEP_DIGITOS): do CEP inteiro para a chave
+    uint32_t d = 1;
+    for (int i = CEP_DIGITOS; i < 8; i++)
+        d *= 10;
+    return d;
+}
+
+#define CEP_IGUAL(a, b) ((a) / divisor_cep() == (b) / divisor_cep())
+
+static inline uint32_t cep_numero(const char * chave){ // Chave de um registro como CEP de 8 digitos, zeros no fim
+    uint32_t v = 0;
+    for (int i = 0; i < CEP_DIGITOS; i++)
+        v = v * 10 + (chave[i] - '0');
+    return v * divisor_cep();
+}
+
+static inline uint32_t hash_cep(uint32_t cep){ // Mistura dos primeiros CEP_DIGITOS digitos (finalizador do murmur3)
+    uint32_t x = cep / divisor_cep() ^ SEED;
+    x ^= x >> 16;
+    x *= 0x85ebca6bu;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35u;
+    return x ^ (x >> 16);
+}
+
+static inline uint32_t hash2_cep(uint32_t cep){ // Segunda mistura, para o passo da sondagem dupla
+    uint32_t x = cep / divisor_cep() ^ ~SEED;
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    return x ^ (x >> 16);
+}
+
+/* FUNCOES DE NORMALIZACAO */
+
+static inline int normaliza_cep(const char * ini, const char * fim, uint32_t * cep){ // Uma consulta [ini, fim), sem o \n
+    while (ini < fim && eh_espaco(*ini))
+        ini++;
+    while (fim > ini && eh_espaco(fim[-1]))
+        fim--;
+    int tam = fim - ini;
+    if (tam != 8 && !(tam == 9 && ini[5] == '-'))
+        return EXIT_FAILURE;
+    uint32_t v = 0;
+    for (int i = 0; i < tam; i++){
+        if (tam == 9 && i == 5)
+            continue;
+        if (ini[i] < '0' || ini[i] > '9')
+            return EXIT_FAILURE;
+        v = v * 10 + (ini[i] - '0');
+    }
+    *cep = v;
+    return EXIT_SUCCESS;
+}
+
+#ifdef __SSE2__
+static inline int normaliza_linha_sse2(const char * p, int * tam, uint32_t * cep){
+    /* Le 16 bytes a partir de p (o chamador garante que existem). Devolve -1
+       se a linha nao termina nesses 16 bytes; senao *tam recebe o tamanho
+       da linha sem o \n e o retorno e EXIT_SUCCESS ou EXIT_FAILURE */
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    __m128i d = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+    unsigned dig = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d)); // '0' <= c <= '9'
+    unsigned hif = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('-')));
+    unsigned esp = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                                                               _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                                                  _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+    unsigned nl = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+    if (nl == 0)
+        return -1;
+    *tam = __builtin_ctz(nl);
+
+    // Nucleo: do primeiro ao ultimo caractere que nao e espaco, sem espacos no meio
+    unsigned nucleo = ~esp & ((1u << *tam) - 1);
+    if (nucleo == 0)
+        return EXIT_FAILURE;
+    int s = __builtin_ctz(nucleo);
+    int n = 32 - __builtin_clz(nucleo) - s;
+    int hifen = n == 9;
+    unsigned esperado = ((1u << n) - 1) << s;
+    if (nucleo != esperado || (n != 8 && !hifen))
+        return EXIT_FAILURE;
+    if (hifen && ((hif & nucleo) != 1u << (s + 5) || (dig & esperado) != (esperado & ~(1u << (s + 5)))))
+        return EXIT_FAILURE;
+    if (!hifen && (dig & esperado) != esperado)
+        return EXIT_FAILURE;
+
+    // Cinco digitos de p + s e tres de p + s + hifen + 5: com hifen, a segunda leitura anda um byte
+    uint64_t a, b;
+    memcpy(&a, p + s, 8);
+    memcpy(&b, p + s + hifen, 8);
+    *cep = digitos_swar((a & 0x000000FFFFFFFFFFull) | (b & 0xFFFFFF0000000000ull));
+    return EXIT_SUCCESS;
+}
+#endif
+
+static inline size_t normaliza_lote(const char * texto, size_t tamanho, uint32_t * ceps, uint64_t * malformados, int max, int * n){
+    /* Normaliza ate max linhas de texto. ceps[i] recebe o CEP da linha i (0 se
+       malformada) e o bit i de malformados marca as invalidas. O fim do texto
+       fecha a ultima linha. Devolve quantos bytes consumiu; *n, quantas linhas */
+    const char * p = texto;
+    const char * fim = texto + tamanho;
+    memset(malformados, 0, sizeof(uint64_t) * ((max + 63) / 64));
+    int i;
+    for (i = 0; i < max && p < fim; i++){
+        int resultado = -1, tam;
+#ifdef __SSE2__
+        if (fim - p >= 16)
+            resultado = normaliza_linha_sse2(p, &tam, &ceps[i]);
+#endif
+        if (resultado == -1){ // Linha longa ou fim do texto
+            const char * nl = memchr(p, '\n', fim - p);
+            tam = (nl != NULL ? nl : fim) - p;
+            resultado = normaliza_cep(p, p + tam, &ceps[i]);
+        }
+        if (resultado == EXIT_FAILURE){
+            ceps[i] = 0;
+            malformados[i / 64] |= 1ull << (i % 64);
+        }
+        p += tam + (p + tam < fim); // Pula o \n
+    }
+    *n = i;
+    return p - texto;
+}
+
+#endif
@@ -0,0 +1,58 @@
+import csv
+import sys
+from collections import defaultdict
+
+import matplotlib.pyplot as plt
+
+# Gera os graficos do comparativo em escala a partir do CSV do bench_escala.sh:
+# tempo por operacao x taxa de ocupacao (como ComparacaoBusca/ComparacaoInsercao)
+# para o maior dataset, e tempo por operacao x numero de linhas para uma taxa.
+# Uso: python3 plota_escala.py [resultados_escala.csv] [taxa]
+
+arquivo = sys.argv[1] if len(sys.argv) > 1 else "resultados_escala.csv"
+taxa_escala = float(sys.argv[2]) if len(sys.argv) > 2 else 0.7
+
+dados = defaultdict(dict)  # (operacao, variante) -> {(linhas, taxa): ns}
+with open(arquivo) as f:
+    for linha in csv.DictReader(f):
+        chave = (int(linha["linhas"]), float(linha["taxa"]))
+        dados[(linha["operacao"], linha["variante"])][chave] = float(linha["ns_op"])
+
+operacoes = sorted({op for op, _ in dados})
+variantes = sorted({v for _, v in dados})
+maior = max(n for pontos in dados.values() for n, _ in pontos)
+marcadores = "osD^v"
+
+for op in operacoes:
+    # Tempo x taxa de ocupacao no maior dataset
+    plt.figure()
+    for i, v in enumerate(variantes):
+        pontos = sorted((t, ns) for (n, t), ns in dados[(op, v)].items() if n == maior)
+        if pontos:
+            plt.plot([t * 100 for t, _ in pontos], [ns for _, ns in pontos],
+                     marker=marcadores[i % len(marcadores)], label=v)
+    plt.title(f"Comparativo de {op} com {maior} linhas")
+    plt.xlabel("Taxa de ocupação (%)")
+    plt.ylabel("Tempo por operação (ns)")
+    plt.grid(True)
+    plt.legend()
+    plt.savefig(f"Comparacao_{op}_taxa.png")
+    plt.close()
+
+    # Tempo x numero de linhas na taxa escolhida
+    plt.figure()
+    for i, v in enumerate(variantes):
+        pontos = sorted((n, ns) for (n, t), ns in dados[(op, v)].items() if abs(t - taxa_escala) < 1e-6)
+        if pontos:
+            plt.plot([n for n, _ in pontos], [ns for _, ns in pontos],
+                     marker=marcadores[i % len(marcadores)], label=v)
+    plt.title(f"Comparativo de {op} com ocupação de {taxa_escala * 100:.0f}%")
+    plt.xscale("log")
+    plt.xlabel("Linhas no dataset")
+    plt.ylabel("Tempo por operação (ns)")
+    plt.grid(True)
+    plt.legend()
+    plt.savefig(f"Comparacao_{op}_escala.png")
+    plt.close()
+
+print("Gráficos gerados.")
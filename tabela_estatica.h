@@ -0,0 +1,45 @@
+#ifndef TABELA_ESTATICA_H
+#define TABELA_ESTATICA_H
+
+/* TABELA HASH ESTATICA
+   Tabela somente leitura gerada pelo gera_tabela.c a partir do ceps.csv:
+   slots e registros sao vetores const, ficam em .rodata e sao mapeados
+   direto do executavel, sem abrir arquivo nem montar nada na partida.
+   Os slots guardam o indice do registro + 1 (0 = vazio) em vez de
+   ponteiros, que exigiriam relocacao. A sondagem e a mesma da tabela
+   linear de hash_tabela.h, com hashf e SEED. */
+
+#include <stdint.h>
+#include <string.h>
+#include "hashf.h"
+#include "cep.h"
+
+/* ESTRUTURA DA TABELA ESTATICA */
+
+typedef struct {
+     const int32_t * slots; // indice do registro + 1, 0 = vazio
+     const tcep * registros;
+     int max;
+     int size;
+}testatica;
+
+/* FUNCOES DA TABELA ESTATICA */
+
+static inline void * estatica_busca(testatica h, const char * key){ // Mesma interface de hash_busca
+    int pos = hashf(key, SEED) % h.max;
+    for (int tentativas = 0; h.slots[pos] != 0 && tentativas < h.max; tentativas++){
+        const tcep * reg = &h.registros[h.slots[pos] - 1];
+        if (strcmp(reg->cep_ini, key) == 0)
+            return (void *)reg;
+        pos = (pos + 1) % h.max;
+    }
+    return NULL;
+}
+
+static inline void * estatica_registro(testatica h, int pos){ // Registro na posicao pos, NULL se vazia
+    if (h.slots[pos] == 0)
+        return NULL;
+    return (void *)&h.registros[h.slots[pos] - 1];
+}
+
+#endif
@@ -0,0 +1,597 @@
+#ifndef TESTES_H
+#define TESTES_H
+
+/* Comparativos comuns as variantes. Usam a tabela e o dataset
+   incluidos antes deste arquivo. */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <pthread.h>
+
+#define NCONSULTAS 1000000
+
+/* TESTE DOS ZEROS A ESQUERDA DO CSV */
+
+static inline void teste_zeros_esquerda(){
+    // O ceps.csv grava 07400-001 como 7400001: sem o zero, Aruja (SP) teria a chave 74000 de Goiania (GO)
+    FILE * file = fopen("ceps.csv", "r");
+    assert(file != NULL);
+    char line[256], copia[256];
+    int mantidas = 0, completadas = 0;
+    tcep cep;
+    assert(fgets(line, sizeof(line), file) != NULL); // Cabecalho
+    while (fgets(line, sizeof(line), file)){
+        strcpy(copia, line);
+        if (le_linha_cep(copia, &cep) == EXIT_FAILURE)
+            continue;
+        char * campo = line;
+        for (int i = 0; i < 3; i++) // CEP Inicial e o quarto campo
+            campo = strchr(campo, ',') + 1;
+        int digitos = strspn(campo, "0123456789");
+        if (digitos == 8){ // Com os 8 digitos a chave e a mesma de antes
+            assert(strncmp(cep.cep_ini, campo, CEP_DIGITOS) == 0);
+            mantidas++;
+        }
+        else {
+            assert(strcmp(cep.estado, "SP") == 0 && cep.cep_ini[0] == '0');
+            assert(strncmp(cep.cep_ini + 8 - digitos, campo, CEP_DIGITOS - (8 - digitos)) == 0);
+            completadas++;
+        }
+    }
+    fclose(file);
+
+    thash h;
+    char aruja[CEP_DIGITOS + 1], goiania[CEP_DIGITOS + 1];
+    snprintf(aruja, sizeof(aruja), "%.*s", CEP_DIGITOS, "07400001");
+    snprintf(goiania, sizeof(goiania), "%.*s", CEP_DIGITOS, "74000001");
+    assert(constroi_dataset(&h, 6100, get_key, 0.7) == EXIT_SUCCESS);
+    tcep * r = (tcep *)hash_busca(h, aruja);
+    assert(r != NULL && strcmp(r->estado, "SP") == 0);
+    r = (tcep *)hash_busca(h, goiania);
+    assert(r != NULL && strcmp(r->estado, "GO") == 0);
+    hash_apaga(&h);
+    printf("Zeros a esquerda: %d chaves mantidas, %d de SP completadas com zero\n", mantidas, completadas);
+}
+
+/* TESTE DO CACHE COM CARGA ZIPF */
+
+#ifdef HASH_TABELA_GENERICA
+static inline const char ** consultas_zipf(thash h, int * nchaves_saida){ // NCONSULTAS chaves da tabela, com popularidade de Zipf
+    // Coleta as chaves presentes na tabela
+    const char ** chaves = malloc(sizeof(char *) * h.size);
+    int nchaves = 0;
+    for (int i = 0; i < h.max; i++){
+        if (hash_registro(h, i) != NULL)
+            chaves[nchaves++] = get_key(hash_registro(h, i));
+    }
+    // Embaralha para a popularidade nao depender da posicao na tabela
+    srand(SEED);
+    for (int i = nchaves - 1; i > 0; i--){
+        int j = rand() % (i + 1);
+        const char * tmp = chaves[i];
+        chaves[i] = chaves[j];
+        chaves[j] = tmp;
+    }
+
+    // Distribuicao acumulada de Zipf com s = 1
+    double * cdf = malloc(sizeof(double) * nchaves);
+    double soma = 0;
+    for (int i = 0; i < nchaves; i++){
+        soma += 1.0 / (i + 1);
+        cdf[i] = soma;
+    }
+    const char ** consultas = malloc(sizeof(char *) * NCONSULTAS);
+    for (int q = 0; q < NCONSULTAS; q++){
+        double u = (double)rand() / RAND_MAX * soma;
+        int ini = 0, fim = nchaves - 1;
+        while (ini < fim){
+            int meio = (ini + fim) / 2;
+            if (cdf[meio] < u)
+                ini = meio + 1;
+            else
+                fim = meio;
+        }
+        consultas[q] = chaves[ini];
+    }
+    free(cdf);
+    free(chaves);
+    *nchaves_saida = nchaves;
+    return consultas;
+}
+
+static inline void teste_cache_zipf(){
+    // O ceps.csv cabe na L2, entao o cache so ganha da sondagem com muitos acertos
+    thash h;
+    int nchaves;
+    assert(constroi_dataset(&h, 6100, get_key, 0.7) == EXIT_SUCCESS);
+    const char ** consultas = consultas_zipf(h, &nchaves);
+
+    printf("Cache com carga Zipf (%d consultas, %d chaves)...\n", NCONSULTAS, nchaves);
+    int tamanhos[] = {0, 16, 64, 256, 1024, 4096};
+    for (int t = 0; t < (int)(sizeof(tamanhos) / sizeof(tamanhos[0])); t++){
+        assert(hash_cache_ativa(&h, tamanhos[t]) == EXIT_SUCCESS);
+
+        long acertos = 0;
+        for (int q = 0; q < NCONSULTAS; q++){
+            if (hash_cache_busca(h, chave_numerica(consultas[q])) != NULL)
+                acertos++;
+            hash_busca(h, consultas[q]);
+        }
+
+        hash_cache_limpa(&h);
+        long encontrados = 0;
+        clock_t start = clock();
+        for (int q = 0; q < NCONSULTAS; q++){
+            if (hash_busca(h, consultas[q]) != NULL)
+                encontrados++;
+        }
+        clock_t end = clock();
+        assert(encontrados == NCONSULTAS);
+
+        double segundos = ((double) (end - start)) / CLOCKS_PER_SEC;
+        printf("Cache %4d entradas: acertos %5.1f%%, %.2f milhoes de buscas/s\n",
+               tamanhos[t], 100.0 * acertos / NCONSULTAS, NCONSULTAS / segundos / 1e6);
+    }
+
+    free(consultas);
+    hash_apaga(&h);
+}
+
+/* TESTE DO CACHE COM LEITORES CONCORRENTES */
+
+#define NLEITORES_CACHE 4
+
+typedef struct {
+     pthread_t thread;
+     thash h; // copia: o cache e compartilhado
+     const char ** consultas;
+     void ** esperados;
+     int ini;
+     long divergencias;
+}tleitor_cache;
+
+static inline void * le_com_cache(void * arg){
+    tleitor_cache * l = (tleitor_cache *)arg;
+    for (int q = 0; q < NCONSULTAS; q++){
+        int i = (l->ini + q) % NCONSULTAS; // Cada leitor comeca num ponto do fluxo
+        if (hash_busca(l->h, l->consultas[i]) != l->esperados[i])
+            l->divergencias++;
+    }
+    return NULL;
+}
+
+static inline void teste_cache_concorrente(){
+    // Leitores disputam um cache pequeno; todo resultado tem de ser o da busca sem cache
+    static char ausentes[64][CEP_DIGITOS + 1];
+    thash h;
+    int nchaves;
+    assert(constroi_dataset(&h, 6100, get_key, 0.7) == EXIT_SUCCESS);
+    const char ** consultas = consultas_zipf(h, &nchaves);
+    srand(SEED);
+    for (int i = 0; i < 64; ){
+        snprintf(ausentes[i], sizeof(ausentes[0]), "%0*u", CEP_DIGITOS, (unsigned)rand() % 100000u);
+        if (hash_busca(h, ausentes[i]) == NULL)
+            i++;
+    }
+    for (int q = 0; q < NCONSULTAS; q += 8) // 1 em 8 consultas nao existe
+        consultas[q] = ausentes[q / 8 % 64];
+    void ** esperados = malloc(sizeof(void *) * NCONSULTAS);
+    for (int q = 0; q < NCONSULTAS; q++)
+        esperados[q] = hash_busca(h, consultas[q]);
+
+    assert(hash_cache_ativa(&h, 64) == EXIT_SUCCESS);
+    tleitor_cache leitores[NLEITORES_CACHE];
+    for (int i = 0; i < NLEITORES_CACHE; i++){
+        leitores[i].h = h;
+        leitores[i].consultas = consultas;
+        leitores[i].esperados = esperados;
+        leitores[i].ini = (int)((long)NCONSULTAS * i / NLEITORES_CACHE);
+        leitores[i].divergencias = 0;
+        if (pthread_create(&leitores[i].thread, NULL, le_com_cache, &leitores[i]) != 0){
+            fprintf(stderr, "Erro ao criar leitor\n");
+            abort();
+        }
+    }
+    long divergencias = 0;
+    for (int i = 0; i < NLEITORES_CACHE; i++){
+        pthread_join(leitores[i].thread, NULL);
+        divergencias += leitores[i].divergencias;
+    }
+    assert(divergencias == 0);
+    printf("Cache com %d leitores concorrentes: %ld buscas iguais as sem cache\n",
+           NLEITORES_CACHE, (long)NLEITORES_CACHE * NCONSULTAS);
+
+    free(esperados);
+    free(consultas);
+    hash_apaga(&h);
+}
+#endif
+
+/* TESTE DE PAGINAS GRANDES */
+
+static inline void teste_paginas_grandes(){
+    int tamanhos[] = {1 << 14, 1 << 18, 1 << 22, 1 << 24};
+    int politicas[] = {ALOCA_CALLOC, ALOCA_PAGINAS_GRANDES};
+
+    // Copia as chaves para nao depender dos registros de cada tabela
+    thash h;
+    assert(constroi_dataset(&h, 6100, get_key, 0.7) == EXIT_SUCCESS);
+    char (*chaves)[sizeof(((tcep *)0)->cep_ini)] = malloc(sizeof(*chaves) * h.size);
+    int nchaves = 0;
+    for (int i = 0; i < h.max; i++){
+        if (hash_registro(h, i) != NULL)
+            strcpy(chaves[nchaves++], get_key(hash_registro(h, i)));
+    }
+    hash_apaga(&h);
+
+    int * consultas = malloc(sizeof(int) * NCONSULTAS);
+    srand(SEED);
+    for (int q = 0; q < NCONSULTAS; q++)
+        consultas[q] = rand() % nchaves;
+
+    printf("Buscas aleatorias com e sem paginas grandes (%d consultas)...\n", NCONSULTAS);
+    for (int t = 0; t < (int)(sizeof(tamanhos) / sizeof(tamanhos[0])); t++){
+        for (int p = 0; p < 2; p++){
+            assert(constroi_dataset_alocacao(&h, tamanhos[t], get_key, 0.99, politicas[p]) == EXIT_SUCCESS);
+            long encontrados = 0;
+            clock_t start = clock();
+            for (int q = 0; q < NCONSULTAS; q++){
+                if (hash_busca(h, chaves[consultas[q]]) != NULL)
+                    encontrados++;
+            }
+            clock_t end = clock();
+            assert(encontrados == NCONSULTAS);
+            double segundos = ((double) (end - start)) / CLOCKS_PER_SEC;
+            printf("Tabela %9d posicoes, %-7s: %.2f milhoes de buscas/s\n",
+                   tamanhos[t], nome_alocacao(h.alocacao), NCONSULTAS / segundos / 1e6);
+#if defined(HASH_NUMA) && defined(HASH_TABELA_GENERICA)
+            thash_numa r;
+            if (hash_replica_numa(&h, &r) == EXIT_SUCCESS){
+                thash * local = hash_replica_local(&r);
+                encontrados = 0;
+                start = clock();
+                for (int q = 0; q < NCONSULTAS; q++){
+                    if (hash_busca(*local, chaves[consultas[q]]) != NULL)
+                        encontrados++;
+                }
+                end = clock();
+                assert(encontrados == NCONSULTAS);
+                segundos = ((double) (end - start)) / CLOCKS_PER_SEC;
+                printf("Tabela %9d posicoes, %-7s: %.2f milhoes de buscas/s (replica local, %d nos)\n",
+                       tamanhos[t], nome_alocacao(r.replicas[0].alocacao), NCONSULTAS / segundos / 1e6, r.nnos);
+                hash_replica_apaga(&r);
+            }
+#endif
+            hash_apaga(&h);
+        }
+    }
+
+    free(consultas);
+    free(chaves);
+}
+
+/* TESTE DE LATENCIA POR OCUPACAO */
+
+#define NREPETICOES 50
+
+static inline int compara_ns(const void * a, const void * b){
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static inline uint64_t agora_ns(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + t.tv_nsec;
+}
+
+static inline void mede_latencia(thash h, char (*chaves)[CEP_DIGITOS + 1], int nchaves, const char * rotulo, float taxa){
+    // Rotulo com a ocupacao medida: a tabela pode ter crescido antes de chegar na taxa pedida
+    int n = nchaves * NREPETICOES;
+    uint64_t * ns = malloc(sizeof(uint64_t) * n);
+    volatile uintptr_t descarte = 0; // Impede que o compilador elimine as buscas
+    for (int r = 0; r < NREPETICOES; r++){
+        for (int i = 0; i < nchaves; i++){
+            uint64_t ini = agora_ns();
+            descarte += (uintptr_t)hash_busca(h, chaves[i]);
+            ns[r * nchaves + i] = agora_ns() - ini;
+        }
+    }
+    (void)descarte;
+    qsort(ns, n, sizeof(uint64_t), compara_ns);
+    float ocupacao = (float)h.size / h.max;
+    printf("Taxa %2.0f%% (ocupacao %4.1f%%) %-7s: p50 %4lu ns, p99.9 %5lu ns, pior %6lu ns%s\n", taxa * 100, ocupacao * 100,
+           rotulo, (unsigned long)ns[n / 2], (unsigned long)ns[(int)(n * 0.999)], (unsigned long)ns[n - 1],
+           ocupacao < taxa - 0.05 ? "  (cresceu antes da taxa)" : "");
+    free(ns);
+}
+
+static inline void teste_latencia(){
+    float taxas[] = {0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 0.95, 0.99};
+    thash h;
+    assert(constroi_dataset(&h, 6100, get_key, 0.7) == EXIT_SUCCESS);
+
+    // Chaves presentes e ausentes, copiadas para valer em todas as tabelas
+    char (*presentes)[CEP_DIGITOS + 1] = malloc(sizeof(*presentes) * h.size);
+    char (*ausentes)[CEP_DIGITOS + 1] = malloc(sizeof(*ausentes) * h.size);
+    int npresentes = 0, nausentes = 0;
+    for (int i = 0; i < h.max; i++){
+        if (hash_registro(h, i) != NULL)
+            strcpy(presentes[npresentes++], get_key(hash_registro(h, i)));
+    }
+    srand(SEED);
+    while (nausentes < npresentes){
+        snprintf(ausentes[nausentes], sizeof(ausentes[0]), "%0*u", CEP_DIGITOS, (unsigned)rand() % 100000u);
+        if (hash_busca(h, ausentes[nausentes]) == NULL)
+            nausentes++;
+    }
+    hash_apaga(&h);
+
+    printf("Latencia de busca por taxa de ocupacao...\n");
+    for (int t = 0; t < (int)(sizeof(taxas) / sizeof(taxas[0])); t++){
+        // Dimensionada para terminar na taxa pedida (linear e dupla); o cuckoo pode crescer antes, ver a ocupacao medida
+        assert(constroi_dataset(&h, (int)(npresentes / taxas[t]) + 2, get_key, taxas[t]) == EXIT_SUCCESS);
+        mede_latencia(h, presentes, npresentes, "acerto", taxas[t]);
+        mede_latencia(h, ausentes, nausentes, "falha", taxas[t]);
+        hash_apaga(&h);
+    }
+    free(presentes);
+    free(ausentes);
+}
+
+/* TESTE DA POLITICA ADAPTATIVA DE OCUPACAO */
+
+#ifdef HASH_TABELA_GENERICA
+#define META_MEDIA 2.0 // slots lidos por busca com acerto
+#define META_CAUDA 32  // slots lidos pelo p99 das buscas com falha
+
+static inline double mede_media_ns(thash h, char (*chaves)[CEP_DIGITOS + 1], int nchaves){ // ns medio por busca
+    volatile uintptr_t descarte = 0;
+    uint64_t ini = agora_ns();
+    for (int r = 0; r < NREPETICOES; r++)
+        for (int i = 0; i < nchaves; i++)
+            descarte += (uintptr_t)hash_busca(h, chaves[i]);
+    (void)descarte;
+    return (double)(agora_ns() - ini) / NREPETICOES / nchaves;
+}
+
+static inline void imprime_adaptativa(thash * h, const char * rotulo, char (*presentes)[CEP_DIGITOS + 1], char (*ausentes)[CEP_DIGITOS + 1], int n){
+    if (h->adapta == NULL) // Tabela de taxa fixa: so mede, nao ha escritas depois
+        assert(hash_adapta_ativa(h, META_MEDIA, META_CAUDA, 0) == EXIT_SUCCESS);
+    hash_adapta_mede(h);
+    printf("%-16s: %6d slots, %5.1f bytes/reg, media %5.2f, cauda %4d, acerto %5.1f ns, falha %5.1f ns%s\n",
+           rotulo, h->max, (double)sizeof(uintptr_t) * h->max / h->size, h->adapta->media, h->adapta->cauda,
+           mede_media_ns(*h, presentes, n), mede_media_ns(*h, ausentes, n),
+           h->adapta->media <= META_MEDIA && h->adapta->cauda <= META_CAUDA ? "  dentro da meta" : "");
+}
+
+static inline void teste_adaptativa(){
+    float taxas[] = {0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 0.95, 0.99};
+    thash h;
+    assert(constroi_dataset(&h, 6100, get_key, 0.7) == EXIT_SUCCESS);
+    char (*presentes)[CEP_DIGITOS + 1] = malloc(sizeof(*presentes) * h.size);
+    char (*ausentes)[CEP_DIGITOS + 1] = malloc(sizeof(*ausentes) * h.size);
+    int n = 0, nausentes = 0;
+    for (int i = 0; i < h.max; i++){
+        if (hash_registro(h, i) != NULL)
+            strcpy(presentes[n++], get_key(hash_registro(h, i)));
+    }
+    srand(SEED);
+    while (nausentes < n){
+        snprintf(ausentes[nausentes], sizeof(ausentes[0]), "%0*u", CEP_DIGITOS, (unsigned)rand() % 100000u);
+        if (hash_busca(h, ausentes[nausentes]) == NULL)
+            nausentes++;
+    }
+    hash_apaga(&h);
+
+    // Taxas fixas, como nas buscas busca10..busca99 (6100 buckets iniciais)
+    printf("Taxa fixa x adaptativa (meta: media %.1f, cauda %d slots)...\n", META_MEDIA, META_CAUDA);
+    int melhor = 0;
+    for (int t = 0; t < (int)(sizeof(taxas) / sizeof(taxas[0])); t++){
+        char rotulo[32];
+        snprintf(rotulo, sizeof(rotulo), "Taxa %2.0f%%", taxas[t] * 100);
+        assert(constroi_dataset(&h, 6100, get_key, taxas[t]) == EXIT_SUCCESS);
+        imprime_adaptativa(&h, rotulo, presentes, ausentes, n);
+        if (h.adapta->media <= META_MEDIA && h.adapta->cauda <= META_CAUDA && (melhor == 0 || h.max < melhor))
+            melhor = h.max; // Menor tabela que cumpre a meta
+        hash_apaga(&h);
+    }
+
+    // Adaptativa: parte da mesma tabela e escolhe a taxa durante a carga
+    assert(hash_constroi(&h, 6100, get_key, 0.7) == EXIT_SUCCESS);
+    assert(hash_adapta_ativa(&h, META_MEDIA, META_CAUDA, 0) == EXIT_SUCCESS);
+    assert(carrega_dataset(&h) == EXIT_SUCCESS);
+    imprime_adaptativa(&h, "Adaptativa", presentes, ausentes, n);
+    printf("Taxa escolhida %.0f%%, %d crescimentos; melhor taxa fixa: %d slots\n",
+           h.taxaocup * 100, h.adapta->crescimentos, melhor);
+
+    // Remove 90% das chaves: a tabela encolhe sozinha e continua achando o resto
+    int maximo = h.max, total = h.size;
+    for (int i = 0; i < n * 9 / 10; i++)
+        assert(hash_remove(&h, presentes[i]) == EXIT_SUCCESS);
+    for (int i = n * 9 / 10; i < n; i++)
+        assert(hash_busca(h, presentes[i]) != NULL);
+    assert(h.size == total - n * 9 / 10 && h.max < maximo);
+    imprime_adaptativa(&h, "Apos remocoes", presentes + n * 9 / 10, ausentes, n - n * 9 / 10);
+    printf("%d -> %d slots, %d reducoes, %d limpezas de lapides\n", maximo, h.max, h.adapta->reducoes, h.adapta->limpezas);
+    hash_apaga(&h);
+
+    // Meta mais apertada com orcamento de memoria: para no maior tamanho que cabe
+    size_t orcamento = sizeof(uintptr_t) * 30000;
+    assert(hash_constroi(&h, 6100, get_key, 0.7) == EXIT_SUCCESS);
+    assert(hash_adapta_ativa(&h, 1.2, 4, orcamento) == EXIT_SUCCESS);
+    assert(carrega_dataset(&h) == EXIT_SUCCESS);
+    assert(sizeof(uintptr_t) * h.max <= orcamento);
+    printf("Meta 1.2/4 com orcamento de %zu KB: %d slots, media %.2f, cauda %d\n",
+           orcamento / 1024, h.max, h.adapta->media, h.adapta->cauda);
+    hash_apaga(&h);
+
+    // hash_reduzir manual numa tabela de taxa fixa esvaziada
+    assert(constroi_dataset(&h, 6100, get_key, 0.7) == EXIT_SUCCESS);
+    maximo = h.max;
+    for (int i = 0; i < n - 10; i++)
+        assert(hash_remove(&h, presentes[i]) == EXIT_SUCCESS);
+    while (hash_reduzir(&h) == EXIT_SUCCESS)
+        ;
+    for (int i = n - 10; i < n; i++)
+        assert(hash_busca(h, presentes[i]) != NULL);
+    printf("hash_reduzir com %d registros: %d -> %d slots\n", h.size, maximo, h.max);
+    hash_apaga(&h);
+
+    free(presentes);
+    free(ausentes);
+}
+#endif
+
+/* TESTE COM CONTADORES DE HARDWARE */
+
+#ifdef CONTADORES_H
+static inline void teste_contadores(){
+    // Construcao, busca e liberacao de cada taxa de busca10..busca99, por operacao
+    float taxas[] = {0.1, 0.3, 0.5, 0.7, 0.9, 0.99};
+    thash h;
+    assert(constroi_dataset(&h, 6100, get_key, 0.7) == EXIT_SUCCESS);
+    char (*chaves)[CEP_DIGITOS + 1] = malloc(sizeof(*chaves) * h.size);
+    int nchaves = 0;
+    for (int i = 0; i < h.max; i++){
+        if (hash_registro(h, i) != NULL)
+            strcpy(chaves[nchaves++], get_key(hash_registro(h, i)));
+    }
+    hash_apaga(&h);
+    int * consultas = malloc(sizeof(int) * NCONSULTAS);
+    srand(SEED);
+    for (int q = 0; q < NCONSULTAS; q++)
+        consultas[q] = rand() % nchaves;
+
+    tcontadores c;
+    int n = contadores_abre(&c);
+    printf("Contadores por operacao (%d de %d eventos disponiveis)...\n", n, NCONTADORES);
+    contadores_cabecalho();
+    for (int t = 0; t < (int)(sizeof(taxas) / sizeof(taxas[0])); t++){
+        char fase[32];
+        contadores_inicia(&c, "construcao");
+        assert(constroi_dataset(&h, 6100, get_key, taxas[t]) == EXIT_SUCCESS);
+        contadores_para(&c, "construcao");
+        snprintf(fase, sizeof(fase), "Taxa %2.0f%% construcao", taxas[t] * 100);
+        contadores_imprime(&c, fase, h.size);
+
+        long encontrados = 0;
+        contadores_inicia(&c, "busca");
+        for (int q = 0; q < NCONSULTAS; q++)
+            encontrados += hash_busca(h, chaves[consultas[q]]) != NULL;
+        contadores_para(&c, "busca");
+        assert(encontrados == NCONSULTAS);
+        snprintf(fase, sizeof(fase), "Taxa %2.0f%% busca", taxas[t] * 100);
+        contadores_imprime(&c, fase, NCONSULTAS);
+
+        int registros = h.size;
+        contadores_inicia(&c, "liberacao");
+        hash_apaga(&h);
+        contadores_para(&c, "liberacao");
+        snprintf(fase, sizeof(fase), "Taxa %2.0f%% liberacao", taxas[t] * 100);
+        contadores_imprime(&c, fase, registros);
+    }
+    contadores_fecha(&c);
+    free(consultas);
+    free(chaves);
+}
+#endif
+
+/* TESTE DO INDICE DE PREFIXO E FAIXA */
+
+#if defined(HASH_TABELA_GENERICA) && defined(CEP_INDICE_H)
+static inline int conta_prefixo_varredura(thash h, const char * prefixo){
+    int n = 0;
+    for (int i = 0; i < h.max; i++){
+        tcep * reg = (tcep *)hash_registro(h, i);
+        if (reg != NULL && strncmp(reg->cep_ini, prefixo, strlen(prefixo)) == 0)
+            n++;
+    }
+    return n;
+}
+
+static inline int conta_intervalo_varredura(thash h, const char * a, const char * b){
+    int n = 0;
+    for (int i = 0; i < h.max; i++){
+        tcep * reg = (tcep *)hash_registro(h, i);
+        if (reg != NULL && atoi(reg->cep_fim) >= atoi(a) && strcmp(reg->cep_ini, b) <= 0)
+            n++;
+    }
+    return n;
+}
+
+static inline void verifica_ordem(tcep * reg, void * ctx){ // Visita deve vir em ordem de cep_ini
+    const char ** anterior = (const char **)ctx;
+    assert(*anterior == NULL || strcmp(*anterior, reg->cep_ini) <= 0);
+    *anterior = reg->cep_ini;
+}
+
+static inline void confere_intervalos(thash h, tindice * ind){ // Faixas sorteadas, das estreitas as largas
+    srand(SEED);
+    for (int i = 0; i < 500; i++){
+        int x = rand() % 100000, y = x + rand() % (i % 2 ? 100 : 100000);
+        char a[12], b[12];
+        snprintf(a, sizeof(a), "%05d", x);
+        snprintf(b, sizeof(b), "%05d", y < 100000 ? y : 99999);
+        const char * anterior = NULL;
+        assert(indice_intervalo(ind, a, b, verifica_ordem, &anterior) == conta_intervalo_varredura(h, a, b));
+    }
+}
+
+static inline void teste_indice(){
+    const char * prefixos[] = {"6", "69", "699", "6994", "69945"};
+    thash h;
+    assert(hash_constroi(&h, 6100, get_key, 0.7) == EXIT_SUCCESS);
+    h.indice = indice_cria();
+    assert(h.indice != NULL);
+    assert(carrega_dataset(&h) == EXIT_SUCCESS);
+    tindice * ind = (tindice *)h.indice;
+
+    printf("Consulta por prefixo: indice x varredura da tabela...\n");
+    for (int p = 0; p < (int)(sizeof(prefixos) / sizeof(prefixos[0])); p++){
+        int nindice = 0, nvarredura = 0;
+        uint64_t ini = agora_ns();
+        for (int r = 0; r < NREPETICOES; r++)
+            nindice = indice_prefixo(ind, prefixos[p], NULL, NULL);
+        uint64_t t_indice = agora_ns() - ini;
+        ini = agora_ns();
+        for (int r = 0; r < NREPETICOES; r++)
+            nvarredura = conta_prefixo_varredura(h, prefixos[p]);
+        uint64_t t_varredura = agora_ns() - ini;
+        assert(nindice == nvarredura);
+        printf("Prefixo %-5s: %4d registros, indice %7lu ns, varredura %7lu ns\n", prefixos[p], nindice,
+               (unsigned long)(t_indice / NREPETICOES), (unsigned long)(t_varredura / NREPETICOES));
+    }
+
+    const char * anterior = NULL;
+    int nfaixa = indice_intervalo(ind, "69900", "69999", verifica_ordem, &anterior);
+    assert(nfaixa == conta_intervalo_varredura(h, "69900", "69999"));
+    printf("Faixas sobrepostas a [69900, 69999]: %d\n", nfaixa);
+    confere_intervalos(h, ind);
+
+    // Remove parte das chaves e confere se o indice acompanha a tabela
+    int removidos = 0;
+    for (int i = 0; i < h.max && removidos < h.size / 2; i++){
+        tcep * reg = (tcep *)hash_registro(h, i);
+        if (reg != NULL && reg->cep_ini[0] == '6'){
+            char chave[CEP_DIGITOS + 1];
+            strcpy(chave, reg->cep_ini);
+            assert(hash_remove(&h, chave) == EXIT_SUCCESS);
+            removidos++;
+        }
+    }
+    for (int p = 0; p < (int)(sizeof(prefixos) / sizeof(prefixos[0])); p++)
+        assert(indice_prefixo(ind, prefixos[p], NULL, NULL) == conta_prefixo_varredura(h, prefixos[p]));
+    assert(indice_intervalo(ind, "10000", "99999", NULL, NULL) == conta_intervalo_varredura(h, "10000", "99999"));
+    assert(indice_prefixo(ind, "", NULL, NULL) == h.size);
+    confere_intervalos(h, ind);
+    printf("Indice consistente apos remover %d registros\n", removidos);
+    hash_apaga(&h);
+}
+#endif
+
+#endif
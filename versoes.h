@@ -0,0 +1,191 @@
+#ifndef VERSOES_H
+#define VERSOES_H
+
+/* VERSOES DA TABELA PARA RECARGA SEM PARADA
+   Os leitores pegam a versao publicada com versao_adquire e a devolvem
+   com versao_solta. versao_recarrega monta a nova versao ao lado a partir
+   de um CSV. Os registros identicos aos da versao anterior sao
+   compartilhados: cada registro conta quantas versoes apontam para ele, e
+   so os que mudaram sao alocados. A publicacao e uma troca atomica do
+   ponteiro, entao o leitor ve a versao velha ou a nova, nunca uma tabela
+   pela metade. A versao velha e liberada quando o ultimo leitor a solta.
+   Memoria extra de uma recarga: os slots da nova versao e os registros
+   alterados, ate a velha ser aposentada.
+
+   Cada adquire/solta custa quatro operacoes atomicas; quem faz muitas
+   buscas seguidas deve segurar a versao pelo lote inteiro. Usa o dataset
+   incluido antes deste arquivo (le_linha_cep). Compilar com -pthread. */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include <pthread.h>
+#include "cep.h"
+
+#define VERSAO_TAM_INICIAL 6100 // slots da primeira versao; as seguintes partem do tamanho da anterior
+
+/* ESTRUTURA DOS REGISTROS COMPARTILHADOS */
+
+typedef struct {
+     tcep cep; // primeiro campo: o registro tambem e um tcep
+     _Atomic int refs; // versoes que apontam para o registro
+}tcep_versao;
+
+static _Atomic long versoes_vivas; // versoes ainda nao liberadas, para os testes
+static _Atomic long registros_vivos; // registros ainda nao liberados, para os testes
+
+static inline void registro_solta(tcep_versao * r){
+    if (atomic_fetch_sub(&r->refs, 1) == 1){
+        free(r);
+        atomic_fetch_sub(&registros_vivos, 1);
+    }
+}
+
+#define HT_PREFIXO          vtab
+#define HT_TIPO             tvtab
+#define HT_CHAVE(h, reg)    (((tcep *)(reg))->cep_ini)
+#define HT_LIBERA(reg)      registro_solta((tcep_versao *)(reg))
+#define HT_TAM_REGISTRO     sizeof(tcep_versao)
+#include "hash_tabela.h"
+
+/* ESTRUTURA DAS VERSOES */
+
+typedef struct {
+     tvtab h; // sem cache nem politica adaptativa: a busca so le a tabela
+     long numero;
+     _Alignas(64) _Atomic long refs; // leitores, mais um enquanto publicada
+}tversao;
+
+typedef struct { // Alocada no heap, precisa de aligned_alloc(_Alignof(tversionada), ...)
+     _Alignas(64) _Atomic(tversao *) atual;
+     _Alignas(64) _Atomic long entrando; // leitores entre ler atual e contar a referencia
+     pthread_mutex_t recarga; // uma recarga por vez
+}tversionada;
+
+typedef struct {
+     int registros;
+     int compartilhados; // registros reaproveitados da versao anterior
+     int novos; // registros alocados por esta recarga
+     size_t bytes_extra; // slots da nova versao + registros novos
+}trecarga;
+
+/* FUNCOES DOS LEITORES */
+
+static inline tversao * versao_adquire(tversionada * v){
+    // Enquanto entrando > 0 a recarga nao solta a versao que acabou de trocar
+    atomic_fetch_add(&v->entrando, 1);
+    tversao * x = atomic_load(&v->atual);
+    atomic_fetch_add(&x->refs, 1);
+    atomic_fetch_sub(&v->entrando, 1);
+    return x;
+}
+
+static inline void versao_solta(tversao * x){ // A ultima referencia libera a versao e os registros so dela
+    if (atomic_fetch_sub(&x->refs, 1) == 1){
+        vtab_apaga(&x->h);
+        free(x);
+        atomic_fetch_sub(&versoes_vivas, 1);
+    }
+}
+
+static inline tcep * versao_busca(tversao * x, const char * key){
+    return (tcep *)vtab_busca(x->h, key);
+}
+
+/* FUNCOES DA RECARGA */
+
+static inline tversao * versao_monta(const char * caminho, tversao * base, float taxaocup, trecarga * r){
+    // Le o CSV numa versao nova; registros iguais aos de base (NULL = nenhuma) sao compartilhados
+    FILE * file = fopen(caminho, "r");
+    if (!file){
+        fprintf(stderr, "Erro ao abrir o arquivo %s\n", caminho);
+        return NULL;
+    }
+    tversao * x = (tversao *)aligned_alloc(_Alignof(tversao), sizeof(tversao)); // malloc so garante 16 bytes
+    int nbuckets = base != NULL ? (int)(base->h.size / taxaocup) + 1 : VERSAO_TAM_INICIAL;
+    if (x == NULL || vtab_constroi(&x->h, nbuckets, get_key, taxaocup) == EXIT_FAILURE){
+        free(x);
+        fclose(file);
+        return NULL;
+    }
+    x->numero = base != NULL ? base->numero + 1 : 1;
+    atomic_init(&x->refs, 1);
+    atomic_fetch_add(&versoes_vivas, 1);
+    memset(r, 0, sizeof(trecarga));
+
+    char line[256];
+    tcep cep;
+    if (fgets(line, sizeof(line), file) == NULL) // Cabecalho
+        line[0] = '\0';
+    while (fgets(line, sizeof(line), file)){
+        if (le_linha_cep(line, &cep) == EXIT_FAILURE)
+            continue;
+        // Com chaves repetidas so a primeira e comparada; as outras iguais viram registro novo
+        tcep_versao * reg = base != NULL ? (tcep_versao *)vtab_busca(base->h, cep.cep_ini) : NULL;
+        if (reg != NULL && memcmp(&reg->cep, &cep, sizeof(tcep)) == 0){
+            atomic_fetch_add(&reg->refs, 1);
+            r->compartilhados++;
+        }
+        else {
+            reg = (tcep_versao *)malloc(sizeof(tcep_versao));
+            if (reg == NULL)
+                break;
+            reg->cep = cep;
+            atomic_init(&reg->refs, 1);
+            atomic_fetch_add(&registros_vivos, 1);
+            r->novos++;
+        }
+        if (vtab_insere(&x->h, reg) == EXIT_FAILURE){
+            printf("Erro ao inserir CEP %s\n", cep.cep_ini);
+            registro_solta(reg);
+        }
+    }
+    int erro = ferror(file) || !feof(file);
+    fclose(file);
+    if (erro){ // CSV lido pela metade nao e publicado
+        versao_solta(x);
+        return NULL;
+    }
+    r->registros = x->h.size;
+    r->bytes_extra = sizeof(uintptr_t) * x->h.max + sizeof(tcep_versao) * r->novos;
+    return x;
+}
+
+static inline int versao_cria(tversionada * v, const char * caminho, float taxaocup){
+    trecarga r;
+    tversao * x = versao_monta(caminho, NULL, taxaocup, &r);
+    if (x == NULL)
+        return EXIT_FAILURE;
+    atomic_init(&v->atual, x);
+    atomic_init(&v->entrando, 0);
+    pthread_mutex_init(&v->recarga, NULL);
+    return EXIT_SUCCESS;
+}
+
+static inline int versao_recarrega(tversionada * v, const char * caminho, trecarga * r){
+    // Monta ao lado e publica; em caso de erro a versao atual continua valendo
+    pthread_mutex_lock(&v->recarga);
+    tversao * velha = atomic_load(&v->atual); // So a recarga troca atual, e ela esta travada
+    tversao * nova = versao_monta(caminho, velha, velha->h.taxaocup, r);
+    if (nova == NULL){
+        pthread_mutex_unlock(&v->recarga);
+        return EXIT_FAILURE;
+    }
+    atomic_store(&v->atual, nova);
+    // Quem leu o ponteiro velho ja contou a referencia quando entrando zera
+    while (atomic_load(&v->entrando) != 0)
+        sched_yield();
+    versao_solta(velha);
+    pthread_mutex_unlock(&v->recarga);
+    return EXIT_SUCCESS;
+}
+
+static inline void versao_apaga(tversionada * v){ // Os leitores que ainda seguram versoes liberam a sua ao soltar
+    versao_solta(atomic_load(&v->atual));
+    pthread_mutex_destroy(&v->recarga);
+}
+
+#endif